@@ -0,0 +1,194 @@
+ #include "batch.h"
+ #include "batch_kernel.h"
+ #include "bitboard.h"
+ #include "fen.h"
+ #include "movegen.h"
+ #include <ostream>
+
+namespace chess {
+
+namespace {
+
+// One position per "lane"; the fallback and the reference for the others
+struct ScalarLanes {
+    using T = uint64_t;
+    static constexpr size_t LANES = 1;
+    static T load(const uint64_t *p) { return *p; }
+    static void store(uint64_t *p, T v) { *p = v; }
+    static T set1(uint64_t v) { return v; }
+    template <int N> static T shl(T v) { return v << N; }
+    template <int N> static T shr(T v) { return v >> N; }
+    static T add(T a, T b) { return a + b; }
+    static T sub(T a, T b) { return a - b; }
+    static T nonzero(T v) { return 0 - T(v != 0); }
+    static bool any(T v) { return v != 0; }
+    static T bytecount(T v) { return T(popcount(v)); }
+    static T add8(T a, T b) { return a + b; }
+    static T sum_bytes(T v) { return v; }
+};
+
+} // namespace
+
+void analyze_batch_scalar(const BatchView &view) {
+    for (size_t i = 0; i < view.count; ++i) batch_kernel::analyze_lanes<ScalarLanes>(view, i);
+}
+
+void PositionBatch::clear() {
+    for (int pt = 0; pt < 6; ++pt) {
+        own[pt].clear();
+        opp[pt].clear();
+    }
+    castle_rooks.clear();
+    en_passant.clear();
+    mirrored.clear();
+    count_ = 0;
+}
+
+static inline Bitboard mirror(Bitboard b) {
+    return __builtin_bswap64(b);
+}
+
+void PositionBatch::push_back(const Position &pos) {
+    if (count_ % BATCH_LANES == 0) {
+        size_t padded = count_ + BATCH_LANES;
+        for (int pt = 0; pt < 6; ++pt) {
+            own[pt].resize(padded);
+            opp[pt].resize(padded);
+        }
+        castle_rooks.resize(padded);
+        en_passant.resize(padded);
+        mirrored.resize(padded);
+    }
+    size_t i = count_++;
+    bool black = pos.side_to_move == BLACK;
+    Color us = pos.side_to_move, them = Color(us ^ 1);
+    for (int pt = 0; pt < 6; ++pt) {
+        Bitboard o = pos.pieces[make_piece(us, PieceType(pt))];
+        Bitboard t = pos.pieces[make_piece(them, PieceType(pt))];
+        own[pt][i] = black ? mirror(o) : o;
+        opp[pt][i] = black ? mirror(t) : t;
+    }
+    int first = black ? 2 : 0;
+    castle_rooks[i] = (pos.has_castle_right(first) ? 1ULL << 7 : 0) |
+                      (pos.has_castle_right(first + 1) ? 1ULL : 0);
+    en_passant[i] = pos.en_passant < 0 ? 0 : 1ULL << (black ? pos.en_passant ^ 56 : pos.en_passant);
+    mirrored[i] = black;
+}
+
+const char *batch_kernel_name(BatchKernel kernel) {
+    switch (kernel) {
+        case BatchKernel::Avx2: return "avx2";
+        case BatchKernel::Avx512: return "avx512";
+        default: return "scalar";
+    }
+}
+
+bool batch_kernel_supported(BatchKernel kernel) {
+#if defined(BATCH_X86_KERNELS)
+    if (kernel == BatchKernel::Avx2) return __builtin_cpu_supports("avx2");
+    if (kernel == BatchKernel::Avx512)
+        return __builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512bw");
+#endif
+    return kernel == BatchKernel::Scalar;
+}
+
+BatchKernel best_batch_kernel() {
+    static const BatchKernel best =
+        batch_kernel_supported(BatchKernel::Avx512) ? BatchKernel::Avx512
+        : batch_kernel_supported(BatchKernel::Avx2) ? BatchKernel::Avx2
+                                                    : BatchKernel::Scalar;
+    return best;
+}
+
+void analyze_batch(const PositionBatch &batch, BatchResults &results, BatchKernel kernel) {
+    size_t padded = batch.castle_rooks.size();
+    results.attacks.resize(padded);
+    results.move_counts.resize(batch.size());
+    results.flags.resize(batch.size());
+    results.lane_info.resize(padded);
+    const uint64_t *info = results.lane_info.data();
+
+    BatchView view;
+    view.count = padded;
+    for (int pt = 0; pt < 6; ++pt) {
+        view.own[pt] = batch.own[pt].data();
+        view.opp[pt] = batch.opp[pt].data();
+    }
+    view.castle_rooks = batch.castle_rooks.data();
+    view.en_passant = batch.en_passant.data();
+    view.attacks = results.attacks.data();
+    view.info = results.lane_info.data();
+    if (!batch_kernel_supported(kernel)) kernel = BatchKernel::Scalar;
+    switch (kernel) {
+#if defined(BATCH_X86_KERNELS)
+        case BatchKernel::Avx2: analyze_batch_avx2(view); break;
+        case BatchKernel::Avx512: analyze_batch_avx512(view); break;
+#endif
+        default: analyze_batch_scalar(view); break;
+    }
+
+    results.attacks.resize(batch.size());
+    for (size_t i = 0; i < batch.size(); ++i) {
+        if (batch.mirrored[i]) results.attacks[i] = mirror(results.attacks[i]);
+        uint16_t moves = uint16_t(info[i] & 0xFFFF);
+        bool check = (info[i] >> 16) & 1;
+        results.move_counts[i] = moves;
+        results.flags[i] = uint8_t((check ? BATCH_IN_CHECK : 0) |
+                                   (moves == 0 ? (check ? BATCH_CHECKMATE : BATCH_STALEMATE) : 0));
+    }
+}
+
+// The attack map a kernel should produce: the side to move's king lifted
+static Bitboard reference_attacks(const Position &pos) {
+    Position lifted = pos;
+    Color us = pos.side_to_move;
+    Piece king = make_piece(us, KING);
+    lifted.occupancies[us] &= ~pos.pieces[king];
+    lifted.pieces[king] = 0;
+    Bitboard attacks = 0;
+    for (int sq = 0; sq < 64; ++sq)
+        if (is_square_attacked(lifted, sq, Color(us ^ 1))) attacks |= 1ULL << sq;
+    return attacks;
+}
+
+bool verify_batch_kernels(const std::vector<Position> &positions, std::ostream &out) {
+    PositionBatch batch;
+    for (const Position &pos : positions) batch.push_back(pos);
+    bool ok = true;
+    int kernels = 0;
+    for (BatchKernel kernel : {BatchKernel::Scalar, BatchKernel::Avx2, BatchKernel::Avx512}) {
+        if (!batch_kernel_supported(kernel)) {
+            out << batch_kernel_name(kernel) << ": not supported on this CPU\n";
+            continue;
+        }
+        ++kernels;
+        BatchResults results;
+        analyze_batch(batch, results, kernel);
+        size_t mismatches = 0;
+        for (size_t i = 0; i < positions.size(); ++i) {
+            const Position &pos = positions[i];
+            int moves = count_legal_moves(pos);
+            bool check = in_check(pos);
+            uint8_t flags = uint8_t((check ? BATCH_IN_CHECK : 0) |
+                (moves == 0 ? (check ? BATCH_CHECKMATE : BATCH_STALEMATE) : 0));
+            if (results.move_counts[i] == moves && results.flags[i] == flags &&
+                results.attacks[i] == reference_attacks(pos))
+                continue;
+            if (++mismatches <= 5) {
+                char fen[FEN_BUFFER_SIZE];
+                write_fen(pos, fen, sizeof(fen));
+                out << batch_kernel_name(kernel) << ": mismatch (moves " << results.move_counts[i]
+                    << " vs " << moves << ", flags " << int(results.flags[i]) << " vs "
+                    << int(flags) << "): " << fen << "\n";
+            }
+        }
+        out << batch_kernel_name(kernel) << ": " << positions.size() - mismatches << "/"
+            << positions.size() << " positions agree\n";
+        ok = ok && mismatches == 0;
+    }
+    out << (ok ? "Batch kernels agree" : "Batch kernels DISAGREE") << " (" << kernels
+        << " kernels, " << positions.size() << " positions)\n";
+    return ok;
+}
+
+} // namespace chess
@@ -0,0 +1,73 @@
+ #ifndef CHESS_BATCH_H
+ #define CHESS_BATCH_H
+
+ #include "position.h"
+ #include <cstddef>
+ #include <cstdint>
+ #include <iosfwd>
+ #include <vector>
+
+namespace chess {
+
+// Positions are processed in blocks of this many lanes (the AVX-512 width)
+constexpr size_t BATCH_LANES = 8;
+
+// Structure-of-arrays block of positions for the batched kernels. Each
+// position is stored from the side to move's point of view: black-to-move
+// positions are mirrored vertically with colors swapped, so every lane
+// pushes its pawns north. Arrays are padded with empty boards to a whole
+// number of blocks.
+class PositionBatch {
+public:
+    void clear();
+    void push_back(const Position &pos);
+    size_t size() const { return count_; }
+
+    std::vector<Bitboard> own[6];      // side to move, by PieceType
+    std::vector<Bitboard> opp[6];
+    std::vector<Bitboard> castle_rooks; // a1/h1 for queen/king side rights
+    std::vector<Bitboard> en_passant;   // ep target square, or 0
+    std::vector<uint8_t> mirrored;
+
+private:
+    size_t count_ = 0;
+};
+
+enum BatchFlag : uint8_t {
+    BATCH_IN_CHECK = 1,
+    BATCH_CHECKMATE = 2,
+    BATCH_STALEMATE = 4,
+};
+
+struct BatchResults {
+    // Squares attacked by the side not to move, seen through the king of
+    // the side to move (the squares that king may not step to)
+    std::vector<Bitboard> attacks;
+    std::vector<uint16_t> move_counts;  // legal moves, as count_legal_moves
+    std::vector<uint8_t> flags;         // BatchFlag bits
+    // Kernel output before unpacking: move count | in check << 16
+    std::vector<uint64_t> lane_info;
+};
+
+// Scalar runs the same set-wise code one position at a time. It is the
+// portable reference, but slower than looping count_legal_moves, whose
+// magic lookups beat Kogge-Stone fills when there is only one lane.
+enum class BatchKernel { Scalar, Avx2, Avx512 };
+
+const char *batch_kernel_name(BatchKernel kernel);
+// Compiled in and supported by this CPU
+bool batch_kernel_supported(BatchKernel kernel);
+// The widest supported kernel
+BatchKernel best_batch_kernel();
+
+// Attack maps, legal move counts and check/mate flags for every position
+void analyze_batch(const PositionBatch &batch, BatchResults &results,
+    BatchKernel kernel = best_batch_kernel());
+
+// Check every supported kernel against count_legal_moves and
+// is_square_attacked on 'positions'; reports mismatches and a summary.
+bool verify_batch_kernels(const std::vector<Position> &positions, std::ostream &out);
+
+} // namespace chess
+
+#endif // CHESS_BATCH_H
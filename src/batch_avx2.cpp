@@ -0,0 +1,43 @@
+ #include "batch_kernel.h"
+ #include <immintrin.h>
+
+// Built with -mavx2 and only called after a runtime CPU check. Keep this
+// file to batch_kernel.h and intrinsics so no AVX2 code leaks into inline
+// functions shared with the rest of the program.
+
+namespace chess {
+
+namespace {
+
+struct Avx2Lanes {
+    using T = __m256i;
+    static constexpr size_t LANES = 4;
+    static T load(const uint64_t *p) { return _mm256_loadu_si256(reinterpret_cast<const T *>(p)); }
+    static void store(uint64_t *p, T v) { _mm256_storeu_si256(reinterpret_cast<T *>(p), v); }
+    static T set1(uint64_t v) { return _mm256_set1_epi64x(int64_t(v)); }
+    template <int N> static T shl(T v) { return _mm256_slli_epi64(v, N); }
+    template <int N> static T shr(T v) { return _mm256_srli_epi64(v, N); }
+    static T add(T a, T b) { return _mm256_add_epi64(a, b); }
+    static T sub(T a, T b) { return _mm256_sub_epi64(a, b); }
+    static T nonzero(T v) { return ~_mm256_cmpeq_epi64(v, _mm256_setzero_si256()); }
+    static bool any(T v) { return !_mm256_testz_si256(v, v); }
+    // Nibble lookup popcount per byte
+    static T bytecount(T v) {
+        const T lut = _mm256_setr_epi8(0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4,
+                                       0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4);
+        const T low = _mm256_set1_epi8(0x0F);
+        return _mm256_add_epi8(_mm256_shuffle_epi8(lut, v & low),
+                               _mm256_shuffle_epi8(lut, _mm256_srli_epi16(v, 4) & low));
+    }
+    static T add8(T a, T b) { return _mm256_add_epi8(a, b); }
+    static T sum_bytes(T v) { return _mm256_sad_epu8(v, _mm256_setzero_si256()); }
+};
+
+} // namespace
+
+void analyze_batch_avx2(const BatchView &view) {
+    for (size_t i = 0; i < view.count; i += Avx2Lanes::LANES)
+        batch_kernel::analyze_lanes<Avx2Lanes>(view, i);
+}
+
+} // namespace chess
@@ -0,0 +1,45 @@
+ #include "batch_kernel.h"
+ #include <immintrin.h>
+
+// Built with -mavx512f -mavx512bw and only called after a runtime CPU
+// check; like batch_avx2.cpp it includes nothing but the kernel and
+// intrinsics.
+
+namespace chess {
+
+namespace {
+
+struct Avx512Lanes {
+    using T = __m512i;
+    static constexpr size_t LANES = 8;
+    static T load(const uint64_t *p) { return _mm512_loadu_si512(p); }
+    static void store(uint64_t *p, T v) { _mm512_storeu_si512(p, v); }
+    static T set1(uint64_t v) { return _mm512_set1_epi64(int64_t(v)); }
+    template <int N> static T shl(T v) { return _mm512_slli_epi64(v, N); }
+    template <int N> static T shr(T v) { return _mm512_srli_epi64(v, N); }
+    static T add(T a, T b) { return _mm512_add_epi64(a, b); }
+    static T sub(T a, T b) { return _mm512_sub_epi64(a, b); }
+    static T nonzero(T v) {
+        return _mm512_maskz_mov_epi64(_mm512_test_epi64_mask(v, v), _mm512_set1_epi64(-1));
+    }
+    static bool any(T v) { return _mm512_test_epi64_mask(v, v) != 0; }
+    // Nibble lookup popcount per byte
+    static T bytecount(T v) {
+        const T lut = _mm512_broadcast_i32x4(_mm_setr_epi8(0, 1, 1, 2, 1, 2, 2, 3,
+                                                           1, 2, 2, 3, 2, 3, 3, 4));
+        const T low = _mm512_set1_epi8(0x0F);
+        return _mm512_add_epi8(_mm512_shuffle_epi8(lut, v & low),
+                               _mm512_shuffle_epi8(lut, _mm512_srli_epi16(v, 4) & low));
+    }
+    static T add8(T a, T b) { return _mm512_add_epi8(a, b); }
+    static T sum_bytes(T v) { return _mm512_sad_epu8(v, _mm512_setzero_si512()); }
+};
+
+} // namespace
+
+void analyze_batch_avx512(const BatchView &view) {
+    for (size_t i = 0; i < view.count; i += Avx512Lanes::LANES)
+        batch_kernel::analyze_lanes<Avx512Lanes>(view, i);
+}
+
+} // namespace chess
@@ -0,0 +1,264 @@
+ #ifndef CHESS_BATCH_KERNEL_H
+ #define CHESS_BATCH_KERNEL_H
+
+// Lane-generic body of the batched position kernels. Each kernel
+// translation unit instantiates analyze_lanes with its own vector type and
+// is built with its own instruction set flags, so this header must stay
+// free of out-of-line code shared with the rest of the program: it uses
+// only plain integers and the V operations below.
+//
+// V provides a lane type T (uint64_t or a vector of 64-bit lanes that
+// supports &, |, ^ and ~), LANES, load/store, set1, shl<N>/shr<N>, add,
+// sub, nonzero (all ones in lanes that are non-zero), any, and a
+// popcount split into bytecount/add8/sum_bytes so several bitboards can
+// be counted before the horizontal sum.
+
+ #include <cstddef>
+ #include <cstdint>
+
+namespace chess {
+
+// Structure-of-arrays view of a PositionBatch; see batch.h for the
+// side-to-move-relative encoding. 'count' is a multiple of the lane count.
+struct BatchView {
+    size_t count;
+    const uint64_t *own[6];       // side to move, indexed by PieceType
+    const uint64_t *opp[6];
+    const uint64_t *castle_rooks; // a1 and/or h1 for the side to move's rights
+    const uint64_t *en_passant;   // the ep target square, on the sixth rank
+    uint64_t *attacks;            // out: squares the opponent attacks
+    uint64_t *info;               // out: move count | in check << 16
+};
+
+void analyze_batch_scalar(const BatchView &view);
+void analyze_batch_avx2(const BatchView &view);
+void analyze_batch_avx512(const BatchView &view);
+
+namespace batch_kernel {
+
+constexpr uint64_t FILE_A = 0x0101010101010101ULL;
+constexpr uint64_t FILE_B = FILE_A << 1;
+constexpr uint64_t FILE_G = FILE_A << 6;
+constexpr uint64_t FILE_H = FILE_A << 7;
+constexpr uint64_t RANK_3 = 0xFFULL << 16;
+constexpr uint64_t RANK_8 = 0xFFULL << 56;
+
+// Squares a step of 'D' may land on without wrapping around the board edge
+static constexpr uint64_t landing_mask(int d) {
+    int file_step = ((d % 8) + 8 + 4) % 8 - 4;  // -2..2 for king and knight steps
+    if (file_step == 1) return ~FILE_A;
+    if (file_step == 2) return ~(FILE_A | FILE_B);
+    if (file_step == -1) return ~FILE_H;
+    if (file_step == -2) return ~(FILE_G | FILE_H);
+    return ~0ULL;
+}
+
+template <class V, int N>
+inline typename V::T raw_shift(typename V::T b) {
+    if constexpr (N >= 0) return V::template shl<N>(b);
+    else return V::template shr<-N>(b);
+}
+
+// One king or knight step in direction 'D'
+template <class V, int D>
+inline typename V::T step(typename V::T b) {
+    return raw_shift<V, D>(b) & V::set1(landing_mask(D));
+}
+
+// Squares attacked from 'gen' along direction 'D' through 'empty',
+// including the first blocker: Kogge-Stone occluded fill, then one step
+template <class V, int D>
+inline typename V::T slide(typename V::T gen, typename V::T empty) {
+    typename V::T pro = empty & V::set1(landing_mask(D));
+    gen = gen | (pro & raw_shift<V, D>(gen));
+    pro = pro & raw_shift<V, D>(pro);
+    gen = gen | (pro & raw_shift<V, 2 * D>(gen));
+    pro = pro & raw_shift<V, 2 * D>(pro);
+    gen = gen | (pro & raw_shift<V, 4 * D>(gen));
+    return step<V, D>(gen);
+}
+
+template <class V>
+inline typename V::T knight_fill(typename V::T b) {
+    return step<V, 17>(b) | step<V, 15>(b) | step<V, 10>(b) | step<V, 6>(b) |
+           step<V, -6>(b) | step<V, -10>(b) | step<V, -15>(b) | step<V, -17>(b);
+}
+
+template <class V>
+inline typename V::T king_fill(typename V::T b) {
+    return step<V, 8>(b) | step<V, -8>(b) | step<V, 1>(b) | step<V, -1>(b) |
+           step<V, 9>(b) | step<V, 7>(b) | step<V, -7>(b) | step<V, -9>(b);
+}
+
+// Pin lines through the king: files, ranks, a1-h8 and h1-a8 diagonals
+enum PinLine { PIN_FILE, PIN_RANK, PIN_DIAG, PIN_ANTI, PIN_LINES };
+
+static constexpr PinLine pin_line(int d) {
+    return d == 8 || d == -8 ? PIN_FILE : d == 1 || d == -1 ? PIN_RANK
+         : d == 9 || d == -9 ? PIN_DIAG : PIN_ANTI;
+}
+
+// Per-lane state shared by the direction passes
+template <class V>
+struct Lanes {
+    using T = typename V::T;
+    T king, us, occ;
+    T diag, orth;           // enemy sliders
+    T checkers, check_mask;
+    T pinned[PIN_LINES];
+};
+
+// Checks and pins along direction 'D' from the king
+template <class V, int D>
+inline void king_ray(Lanes<V> &s) {
+    using T = typename V::T;
+    T sliders = (D == 8 || D == -8 || D == 1 || D == -1) ? s.orth : s.diag;
+    T ray = slide<V, D>(s.king, ~s.occ);
+    T hit = ray & sliders;
+    s.checkers = s.checkers | hit;
+    s.check_mask = s.check_mask | (ray & V::nonzero(hit));
+    // Look through our first blocker for a pinner
+    T blocker = ray & s.us;
+    T xray = slide<V, D>(s.king, ~(s.occ ^ blocker));
+    s.pinned[pin_line(D)] = s.pinned[pin_line(D)] | (blocker & V::nonzero(xray & sliders));
+}
+
+// Would the king be attacked by a slider with the board holding 'occ'?
+template <class V>
+inline typename V::T slider_attacks_king(const Lanes<V> &s, typename V::T occ) {
+    typename V::T empty = ~occ;
+    return (slide<V, 8>(s.king, empty) & s.orth) | (slide<V, -8>(s.king, empty) & s.orth) |
+           (slide<V, 1>(s.king, empty) & s.orth) | (slide<V, -1>(s.king, empty) & s.orth) |
+           (slide<V, 9>(s.king, empty) & s.diag) | (slide<V, -9>(s.king, empty) & s.diag) |
+           (slide<V, 7>(s.king, empty) & s.diag) | (slide<V, -7>(s.king, empty) & s.diag);
+}
+
+// Count slider moves along 'D'. Rays of two sliders in one direction
+// only meet on the nearer slider's square, which holds our own piece, so
+// a set-wise fill counts every move exactly once.
+template <class V, int D>
+inline typename V::T slider_moves(const Lanes<V> &s, typename V::T sliders,
+    typename V::T targets) {
+    typename V::T movers = sliders & (~(s.pinned[0] | s.pinned[1] | s.pinned[2] | s.pinned[3]) |
+                                      s.pinned[pin_line(D)]);
+    return V::bytecount(slide<V, D>(movers, ~s.occ) & targets);
+}
+
+// Analyze V::LANES positions starting at index 'i'
+template <class V>
+inline void analyze_lanes(const BatchView &view, size_t i) {
+    using T = typename V::T;
+    enum { P, N, B, R, Q, K };
+    T own[6], opp[6];
+    for (int pt = 0; pt < 6; ++pt) {
+        own[pt] = V::load(view.own[pt] + i);
+        opp[pt] = V::load(view.opp[pt] + i);
+    }
+    Lanes<V> s;
+    s.king = own[K];
+    s.us = own[P] | own[N] | own[B] | own[R] | own[Q] | own[K];
+    T them = opp[P] | opp[N] | opp[B] | opp[R] | opp[Q] | opp[K];
+    s.occ = s.us | them;
+    s.diag = opp[B] | opp[Q];
+    s.orth = opp[R] | opp[Q];
+
+    // Enemy attacks with our king lifted, so it cannot hide behind itself
+    T empty = ~(s.occ ^ s.king);
+    T attacked = step<V, -7>(opp[P]) | step<V, -9>(opp[P]) | knight_fill<V>(opp[N]) |
+                 king_fill<V>(opp[K]) |
+                 slide<V, 8>(s.orth, empty) | slide<V, -8>(s.orth, empty) |
+                 slide<V, 1>(s.orth, empty) | slide<V, -1>(s.orth, empty) |
+                 slide<V, 9>(s.diag, empty) | slide<V, -9>(s.diag, empty) |
+                 slide<V, 7>(s.diag, empty) | slide<V, -7>(s.diag, empty);
+    V::store(view.attacks + i, attacked);
+
+    // Checkers, the evasion mask and pins, all from the king square
+    s.checkers = ((step<V, 7>(s.king) | step<V, 9>(s.king)) & opp[P]) |
+                 (knight_fill<V>(s.king) & opp[N]);
+    s.check_mask = s.checkers;
+    for (T &p : s.pinned) p = V::set1(0);
+    king_ray<V, 8>(s);
+    king_ray<V, -8>(s);
+    king_ray<V, 1>(s);
+    king_ray<V, -1>(s);
+    king_ray<V, 9>(s);
+    king_ray<V, -9>(s);
+    king_ray<V, 7>(s);
+    king_ray<V, -7>(s);
+    T in_check = V::nonzero(s.checkers);
+    T double_check = V::nonzero(s.checkers & V::sub(s.checkers, V::set1(1)));
+    // Everything is allowed out of check; only the king moves in double check
+    T check_mask = (s.check_mask | ~in_check) & ~double_check;
+    T pinned = s.pinned[PIN_FILE] | s.pinned[PIN_RANK] | s.pinned[PIN_DIAG] | s.pinned[PIN_ANTI];
+    T targets = ~s.us & check_mask;
+
+    // Per-byte counts stay below 256: a byte counts moves landing on one rank
+    T count = V::bytecount(king_fill<V>(s.king) & ~s.us & ~attacked);
+
+    T knights = own[N] & ~pinned;
+    count = V::add8(count, V::bytecount(step<V, 17>(knights) & targets));
+    count = V::add8(count, V::bytecount(step<V, 15>(knights) & targets));
+    count = V::add8(count, V::bytecount(step<V, 10>(knights) & targets));
+    count = V::add8(count, V::bytecount(step<V, 6>(knights) & targets));
+    count = V::add8(count, V::bytecount(step<V, -6>(knights) & targets));
+    count = V::add8(count, V::bytecount(step<V, -10>(knights) & targets));
+    count = V::add8(count, V::bytecount(step<V, -15>(knights) & targets));
+    count = V::add8(count, V::bytecount(step<V, -17>(knights) & targets));
+
+    T orth = own[R] | own[Q], diag = own[B] | own[Q];
+    count = V::add8(count, slider_moves<V, 8>(s, orth, targets));
+    count = V::add8(count, slider_moves<V, -8>(s, orth, targets));
+    count = V::add8(count, slider_moves<V, 1>(s, orth, targets));
+    count = V::add8(count, slider_moves<V, -1>(s, orth, targets));
+    count = V::add8(count, slider_moves<V, 9>(s, diag, targets));
+    count = V::add8(count, slider_moves<V, -9>(s, diag, targets));
+    count = V::add8(count, slider_moves<V, 7>(s, diag, targets));
+    count = V::add8(count, slider_moves<V, -7>(s, diag, targets));
+
+    // Pawns push along a file pin and capture along a diagonal pin
+    T free = ~pinned;
+    T empty_sq = ~s.occ;
+    T single = step<V, 8>(own[P] & (free | s.pinned[PIN_FILE])) & empty_sq;
+    T dbl = step<V, 8>(single & V::set1(RANK_3)) & empty_sq & check_mask;
+    single = single & check_mask;
+    T cap_east = step<V, 9>(own[P] & (free | s.pinned[PIN_DIAG])) & them & check_mask;
+    T cap_west = step<V, 7>(own[P] & (free | s.pinned[PIN_ANTI])) & them & check_mask;
+    count = V::add8(count, V::add8(V::add8(V::bytecount(single), V::bytecount(dbl)),
+                                   V::add8(V::bytecount(cap_east), V::bytecount(cap_west))));
+    // Promotions count four times: three more for each move onto the last rank
+    T last = V::set1(RANK_8);
+    T promo = V::add8(V::add8(V::bytecount(single & last), V::bytecount(cap_east & last)),
+                      V::bytecount(cap_west & last));
+    count = V::add8(count, V::add8(promo, V::add8(promo, promo)));
+    T total = V::sum_bytes(count);
+
+    // Castling: rights, an empty path, and no attacked square from the
+    // king to its destination (which also rules out being in check)
+    T rooks = V::load(view.castle_rooks + i);
+    T short_ok = V::nonzero(rooks & V::set1(1ULL << 7)) &
+                 ~V::nonzero(s.occ & V::set1(0x60ULL)) & ~V::nonzero(attacked & V::set1(0x70ULL));
+    T long_ok = V::nonzero(rooks & V::set1(1ULL << 0)) &
+                ~V::nonzero(s.occ & V::set1(0x0EULL)) & ~V::nonzero(attacked & V::set1(0x1CULL));
+    total = V::add(total, V::add(short_ok & V::set1(1), long_ok & V::set1(1)));
+
+    // En passant is rare; play it out only when some lane has a square
+    T ep = V::load(view.en_passant + i);
+    if (V::any(ep)) {
+        T captured = raw_shift<V, -8>(ep);
+        T resolves = V::nonzero((ep & check_mask) | (captured & s.checkers)) & ~double_check;
+        T from_west = step<V, -9>(ep) & own[P];
+        T from_east = step<V, -7>(ep) & own[P];
+        T west_ok = V::nonzero(from_west) & resolves &
+                    ~V::nonzero(slider_attacks_king(s, (s.occ ^ from_west ^ captured) | ep));
+        T east_ok = V::nonzero(from_east) & resolves &
+                    ~V::nonzero(slider_attacks_king(s, (s.occ ^ from_east ^ captured) | ep));
+        total = V::add(total, V::add(west_ok & V::set1(1), east_ok & V::set1(1)));
+    }
+
+    V::store(view.info + i, total | V::template shl<16>(in_check & V::set1(1)));
+}
+
+} // namespace batch_kernel
+} // namespace chess
+
+ #endif // CHESS_BATCH_KERNEL_H
@@ -0,0 +1,348 @@
+ #include "batch.h"
+ #include "bitboard.h"
+ #include "corpus.h"
+ #include "fen.h"
+ #include "movegen.h"
+ #include "position.h"
+ #include <algorithm>
+ #include <chrono>
+ #include <cmath>
+ #include <cstdint>
+ #include <fstream>
+ #include <functional>
+ #include <iomanip>
+ #include <iostream>
+ #include <string>
+ #include <vector>
+
+// Microbenchmarks for the hot primitives behind perft. Each benchmark runs
+// one operation over a fixed corpus of positions; after a warm-up that
+// also sizes the batch, it is timed for a number of repetitions and
+// reported as ns/op (mean, min and standard deviation across repetitions).
+
+using namespace chess;
+
+namespace {
+
+// Openings, middlegames with pins and checks, and sparse endgames
+const char *const corpus_fens[] = {
+    "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",
+    "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+    "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1",
+    "r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1",
+    "rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8",
+    "r4rk1/1pp1qppp/p1np1n2/2b1p1B1/2B1P1b1/P1NP1N2/1PP1QPPP/R4RK1 w - - 0 10",
+    "r1bqkb1r/pppp1ppp/2n2n2/4p2Q/2B1P3/8/PPPP1PPP/RNB1K1NR w KQkq - 4 4",
+    "rnbqkb1r/pp3ppp/4pn2/2pp4/2PP4/2N1PN2/PP3PPP/R1BQKB1R b KQkq - 0 5",
+    "2r2rk1/pp1bqppp/2n1pn2/3p4/2PP4/P1NBPN2/1P3PPP/2RQ1RK1 b - - 2 12",
+    "r1b2rk1/2q1bppp/p2p1n2/np2p3/3PP3/5N1P/PPBN1PP1/R1BQR1K1 b - - 0 13",
+    "3r1rk1/p4ppp/1qn1p3/3pP3/3P4/P2B1N2/5PPP/R2Q1RK1 w - - 0 18",
+    "8/8/1k6/2b5/2pP4/8/5K2/8 b - d3 0 1",
+    "6k1/5ppp/8/8/8/8/5PPP/3R2K1 w - - 0 1",
+    "8/5k2/3p4/1p1Pp2p/pP2Pp1P/P4P1K/8/8 b - - 99 50",
+    "4k3/1P6/8/8/8/8/K7/8 w - - 0 1",
+    "r3k2r/8/3Q4/8/8/5q2/8/R3K2R b KQkq - 0 1",
+};
+
+volatile uint64_t sink;
+
+struct Result {
+    std::string name;
+    uint64_t ops_per_rep;
+    int reps;
+    double mean_ns, min_ns, stddev_ns;
+};
+
+// Runs 'batch' (which performs 'ops_per_batch' operations) until a batch
+// count takes at least 'min_rep_ms', then times 'reps' repetitions of it.
+Result run_benchmark(const std::string &name, uint64_t ops_per_batch,
+    const std::function<uint64_t()> &batch, int reps, double min_rep_ms) {
+    using clock = std::chrono::steady_clock;
+    uint64_t batches = 1;
+    for (;;) {
+        auto t0 = clock::now();
+        uint64_t acc = 0;
+        for (uint64_t b = 0; b < batches; ++b) acc += batch();
+        sink = acc;
+        double ms = std::chrono::duration<double, std::milli>(clock::now() - t0).count();
+        if (ms >= min_rep_ms) break;
+        batches *= 2;
+    }
+    std::vector<double> samples;
+    for (int r = 0; r < reps; ++r) {
+        auto t0 = clock::now();
+        uint64_t acc = 0;
+        for (uint64_t b = 0; b < batches; ++b) acc += batch();
+        sink = acc;
+        double ns = std::chrono::duration<double, std::nano>(clock::now() - t0).count();
+        samples.push_back(ns / double(batches * ops_per_batch));
+    }
+    double mean = 0;
+    for (double s : samples) mean += s;
+    mean /= samples.size();
+    double var = 0;
+    for (double s : samples) var += (s - mean) * (s - mean);
+    var = samples.size() > 1 ? var / (samples.size() - 1) : 0;
+    return {name, batches * ops_per_batch, reps, mean,
+            *std::min_element(samples.begin(), samples.end()), std::sqrt(var)};
+}
+
+void print_usage(const char *prog) {
+    std::cout << "Usage: " << prog << " [--reps N] [--min-ms MS] [--filter NAME] [--json FILE]\n";
+}
+
+} // namespace
+
+int main(int argc, char *argv[]) {
+    int reps = 10;
+    double min_rep_ms = 50;
+    std::string filter, json_path;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--reps" && i + 1 < argc) {
+            reps = std::max(1, std::stoi(argv[++i]));
+        } else if (arg == "--min-ms" && i + 1 < argc) {
+            min_rep_ms = std::stod(argv[++i]);
+        } else if (arg == "--filter" && i + 1 < argc) {
+            filter = argv[++i];
+        } else if (arg == "--json" && i + 1 < argc) {
+            json_path = argv[++i];
+        } else {
+            print_usage(argv[0]);
+            return 1;
+        }
+    }
+
+    std::vector<Position> positions;
+    std::vector<std::string> fens;
+    std::vector<MoveList> legal;
+    for (const char *fen : corpus_fens) {
+        Position pos;
+        if (!set_fen(pos, fen)) {
+            std::cout << "Invalid corpus FEN: " << fen << "\n";
+            return 1;
+        }
+        MoveList moves;
+        generate_legal_moves(pos, moves);
+        positions.push_back(pos);
+        fens.push_back(fen);
+        legal.push_back(moves);
+    }
+    std::string fen_lines;
+    for (const std::string &fen : fens) fen_lines += fen + "\n";
+    std::vector<Position> batch(positions.size());
+    std::vector<PackedPosition> packed(positions.size());
+    std::vector<Position> copies(positions.size());
+    for (size_t i = 0; i < positions.size(); ++i) pack_position(positions[i], packed[i]);
+    uint64_t total_moves = 0;
+    std::vector<std::string> uci_moves;
+    for (const MoveList &ml : legal) {
+        total_moves += ml.size();
+        for (Move m : ml) uci_moves.push_back(move_to_uci(m));
+    }
+    const uint64_t n = positions.size();
+
+    // The corpus and every position one ply below it, for the batched kernels
+    std::vector<Position> expanded;
+    PositionBatch position_batch;
+    for (size_t i = 0; i < n; ++i) {
+        expanded.push_back(positions[i]);
+        for (Move m : legal[i]) {
+            Position child = positions[i];
+            make_move(child, m);
+            expanded.push_back(child);
+        }
+    }
+    for (const Position &pos : expanded) position_batch.push_back(pos);
+    BatchResults batch_results;
+    auto run_batch = [&](BatchKernel kernel) {
+        analyze_batch(position_batch, batch_results, kernel);
+        uint64_t acc = 0;
+        for (uint16_t c : batch_results.move_counts) acc += c;
+        return acc;
+    };
+
+    std::vector<std::pair<std::string, std::pair<uint64_t, std::function<uint64_t()>>>> benches = {
+        {"generate_legal_moves", {n, [&] {
+            uint64_t acc = 0;
+            MoveList moves;
+            for (const Position &pos : positions) {
+                generate_legal_moves(pos, moves);
+                acc += moves.size();
+            }
+            return acc;
+        }}},
+        {"count_legal_moves", {n, [&] {
+            uint64_t acc = 0;
+            for (const Position &pos : positions) acc += count_legal_moves(pos);
+            return acc;
+        }}},
+        {"is_legal", {total_moves, [&] {
+            uint64_t acc = 0;
+            for (size_t i = 0; i < n; ++i)
+                for (Move m : legal[i]) acc += is_legal(positions[i], m);
+            return acc;
+        }}},
+        {"move_from_uci", {total_moves, [&] {
+            uint64_t acc = 0;
+            size_t k = 0;
+            for (size_t i = 0; i < n; ++i)
+                for (int j = 0; j < legal[i].size(); ++j)
+                    acc += move_from_uci(positions[i], uci_moves[k++]).data;
+            return acc;
+        }}},
+        {"copy_position", {n, [&] {
+            uint64_t acc = 0;
+            for (size_t i = 0; i < n; ++i) {
+                copies[i] = positions[i];
+                acc += copies[i].key;
+            }
+            return acc;
+        }}},
+        {"make_move_copy", {total_moves, [&] {
+            uint64_t acc = 0;
+            for (size_t i = 0; i < n; ++i) {
+                for (Move m : legal[i]) {
+                    Position child = positions[i];
+                    make_move(child, m);
+                    acc += child.key;
+                }
+            }
+            return acc;
+        }}},
+        {"make_unmake_move", {total_moves, [&] {
+            uint64_t acc = 0;
+            UndoInfo undo;
+            for (size_t i = 0; i < n; ++i) {
+                Position &pos = positions[i];
+                for (Move m : legal[i]) {
+                    make_move(pos, m, undo);
+                    acc += pos.key;
+                    unmake_move(pos, m, undo);
+                }
+            }
+            return acc;
+        }}},
+        {"is_square_attacked", {n * 64, [&] {
+            uint64_t acc = 0;
+            for (const Position &pos : positions) {
+                Color them = pos.side_to_move == WHITE ? BLACK : WHITE;
+                for (int sq = 0; sq < 64; ++sq) acc += is_square_attacked(pos, sq, them);
+            }
+            return acc;
+        }}},
+        {"sliding_attacks", {n * 64 * 2, [&] {
+            uint64_t acc = 0;
+            for (const Position &pos : positions) {
+                Bitboard occ = pos.occupied();
+                for (int sq = 0; sq < 64; ++sq)
+                    acc += sliding_attacks(sq, occ, bishop_dirs, 4) ^
+                           sliding_attacks(sq, occ, rook_dirs, 4);
+            }
+            return acc;
+        }}},
+        {"slider_table_lookup", {n * 64 * 2, [&] {
+            uint64_t acc = 0;
+            for (const Position &pos : positions) {
+                Bitboard occ = pos.occupied();
+                for (int sq = 0; sq < 64; ++sq)
+                    acc += bishop_attacks(sq, occ) ^ rook_attacks(sq, occ);
+            }
+            return acc;
+        }}},
+        {"set_fen", {n, [&] {
+            uint64_t acc = 0;
+            Position pos;
+            for (const std::string &fen : fens) acc += set_fen(pos, fen) ? pos.key : 0;
+            return acc;
+        }}},
+        {"get_fen", {n, [&] {
+            uint64_t acc = 0;
+            for (const Position &pos : positions) acc += get_fen(pos).size();
+            return acc;
+        }}},
+        {"parse_fen", {n, [&] {
+            uint64_t acc = 0;
+            Position pos;
+            for (const std::string &fen : fens)
+                acc += parse_fen(fen, pos) == FenError::None ? pos.key : 0;
+            return acc;
+        }}},
+        {"write_fen", {n, [&] {
+            uint64_t acc = 0;
+            char buf[FEN_BUFFER_SIZE];
+            for (const Position &pos : positions) acc += write_fen(pos, buf, sizeof(buf));
+            return acc;
+        }}},
+        {"pack_position", {n, [&] {
+            uint64_t acc = 0;
+            for (size_t i = 0; i < n; ++i) {
+                pack_position(positions[i], packed[i]);
+                acc += packed[i].occupied;
+            }
+            return acc;
+        }}},
+        {"unpack_position", {n, [&] {
+            uint64_t acc = 0;
+            Position pos;
+            for (const PackedPosition &p : packed) acc += unpack_position(p, pos) ? pos.key : 0;
+            return acc;
+        }}},
+        {"parse_fen_lines", {n, [&] {
+            return uint64_t(parse_fen_lines(fen_lines, batch.data(), nullptr, batch.size()));
+        }}},
+    };
+    // Positions/sec of the batched kernels against the scalar generator
+    // answering the same question one position at a time
+    benches.push_back({"batch_scalar_loop", {expanded.size(), [&] {
+        uint64_t acc = 0;
+        for (const Position &pos : expanded) acc += count_legal_moves(pos) + in_check(pos);
+        return acc;
+    }}});
+    for (BatchKernel kernel : {BatchKernel::Scalar, BatchKernel::Avx2, BatchKernel::Avx512}) {
+        if (!batch_kernel_supported(kernel)) continue;
+        benches.push_back({std::string("batch_") + batch_kernel_name(kernel),
+                           {expanded.size(), [&run_batch, kernel] { return run_batch(kernel); }}});
+    }
+
+    std::vector<Result> results;
+    std::cout << std::left << std::setw(22) << "benchmark" << std::right << std::setw(12)
+              << "ns/op" << std::setw(12) << "min" << std::setw(12) << "stddev"
+              << std::setw(16) << "ops/sec" << "\n";
+    for (const auto &[name, bench] : benches) {
+        if (!filter.empty() && name.find(filter) == std::string::npos) continue;
+        Result r = run_benchmark(name, bench.first, bench.second, reps, min_rep_ms);
+        results.push_back(r);
+        std::cout << std::left << std::setw(22) << r.name << std::right << std::fixed
+                  << std::setprecision(2) << std::setw(12) << r.mean_ns << std::setw(12)
+                  << r.min_ns << std::setw(12) << r.stddev_ns << std::setprecision(0)
+                  << std::setw(16) << 1e9 / r.mean_ns << "\n";
+    }
+
+    if (!json_path.empty()) {
+        std::ofstream out(json_path);
+        if (!out) {
+            std::cout << "Cannot write " << json_path << "\n";
+            return 1;
+        }
+#if defined(USE_PEXT)
+        const char *slider_index = "pext";
+#else
+        const char *slider_index = "magic";
+#endif
+        out << std::setprecision(4) << std::fixed;
+        out << "{\n  \"corpus_positions\": " << n << ",\n  \"slider_index\": \""
+            << slider_index << "\",\n  \"benchmarks\": [\n";
+        for (size_t i = 0; i < results.size(); ++i) {
+            const Result &r = results[i];
+            out << "    {\"name\": \"" << r.name << "\", \"reps\": " << r.reps
+                << ", \"ops_per_rep\": " << r.ops_per_rep << ", \"ns_per_op\": " << r.mean_ns
+                << ", \"ns_per_op_min\": " << r.min_ns << ", \"ns_per_op_stddev\": "
+                << r.stddev_ns << ", \"ns_per_op_variance\": " << r.stddev_ns * r.stddev_ns
+                << ", \"ops_per_sec\": " << 1e9 / r.mean_ns << "}"
+                << (i + 1 < results.size() ? "," : "") << "\n";
+        }
+        out << "  ]\n}\n";
+    }
+    return 0;
+}
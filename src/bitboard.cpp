@@ -2,84 +2,157 @@
 
 namespace chess {
 
-Bitboard knight_attacks[64];
-Bitboard king_attacks[64];
-Bitboard pawn_attacks[2][64];
+// Fancy magic multipliers; each maps its square's relevant occupancies
+// onto a collision-free index of popcount(mask) bits
+static constexpr Bitboard bishop_magic_numbers[64] = {
+    0x10102002004A1420ULL, 0x8020040400584008ULL, 0x10510800811201C8ULL, 0x5204042080000088ULL,
+    0x2204106880000002ULL, 0x1401042004000000ULL, 0x0400880410042004ULL, 0x0028208200A02020ULL,
+    0x1500241990010E00ULL, 0x8001200182020A40ULL, 0x40004101030B0000ULL, 0x8002041042000100ULL,
+    0x4010011041020038ULL, 0x0000010421044000ULL, 0x1500210808020A00ULL, 0x8000088400880520ULL,
+    0x0405004010040100ULL, 0x1005823210040108ULL, 0x2708008102040011ULL, 0x4048200404009100ULL,
+    0x0018104101400024ULL, 0x0003000601190101ULL, 0x8004803108491000ULL, 0x8014241200820800ULL,
+    0x0006E080100C3040ULL, 0x0501044A11041800ULL, 0x9020300008004045ULL, 0x0894080000220040ULL,
+    0x1001010083104000ULL, 0x5004030040900080ULL, 0x000400422C012400ULL, 0x0002128698404812ULL,
+    0x1010108404900440ULL, 0x0928021182084100ULL, 0x2006080409020024ULL, 0x1010202020180080ULL,
+    0xA010008200202200ULL, 0x2098015100019004ULL, 0x0002041440810811ULL, 0x802A02020000B098ULL,
+    0x0009015090004060ULL, 0x4000821082081001ULL, 0x0100210040420800ULL, 0x0800004010488A00ULL,
+    0x2000081104004040ULL, 0x4C8E029015000082ULL, 0x0420340322224842ULL, 0x1298260043400210ULL,
+    0x0000822802400008ULL, 0x00008A0101600000ULL, 0x3040003412080021ULL, 0x3040290220884800ULL,
+    0x4A1500401041004AULL, 0x8010200282020781ULL, 0x0020203142209091ULL, 0x0070300600902110ULL,
+    0x0040808800B62048ULL, 0x0000810400C44420ULL, 0x00080400440C0441ULL, 0x8340080020840411ULL,
+    0x0000000104208200ULL, 0x0000800810D00080ULL, 0x0400530411080200ULL, 0x4040702400932244ULL
+};
 
-// Sliding attacks for bishops, rooks, and queens
-Bitboard sliding_attacks(int sq, Bitboard occ, const int *deltas, int count) {
-    Bitboard attacks = 0;
-    for (int i = 0; i < count; ++i) {
-        int dir = deltas[i];
-        int s = sq;
-        while (true) {
-            int r = s / 8, f = s % 8;
-            bool edge = false;
-            if ((dir == 1 || dir == 9 || dir == -7) && f == 7) edge = true;
-            else if ((dir == -1 || dir == 7 || dir == -9) && f == 0) edge = true;
-            if (edge) break;
-            s += dir;
-            if (s < 0 || s > 63) break;
-            attacks |= (1ULL << s);
-            if (occ & (1ULL << s)) break;
-        }
-    }
-    return attacks;
+static constexpr Bitboard rook_magic_numbers[64] = {
+    0x1080004008801020ULL, 0x0840092002C03000ULL, 0x1900200010400900ULL, 0x0880100008000480ULL,
+    0x4200100420080200ULL, 0x8100020100080400ULL, 0x0200040110886200ULL, 0x0200008040220411ULL,
+    0x0404800084400220ULL, 0x0000401000402000ULL, 0x0086001081220440ULL, 0x0408800800100280ULL,
+    0x000A001201040820ULL, 0x8848800200840080ULL, 0x4001000100040200ULL, 0x0442000102105084ULL,
+    0x9080010020804100ULL, 0x0040404000201009ULL, 0x0000808010002009ULL, 0x2200090021D00100ULL,
+    0x0008008008040080ULL, 0x0004004002010040ULL, 0x0011040008015042ULL, 0x00000A0001768104ULL,
+    0x0000800080204009ULL, 0x2010004140002001ULL, 0x9800200280100080ULL, 0x1000100080080080ULL,
+    0x0442000A00049020ULL, 0x2100040080020080ULL, 0x0800120400900148ULL, 0x0010040A00128541ULL,
+    0x2800804000800030ULL, 0x1010002000400041ULL, 0x4000200011004100ULL, 0x0610008410800800ULL,
+    0x0400802402800800ULL, 0xC100020080800400ULL, 0x0002000802000401ULL, 0x0182085882000401ULL,
+    0x0220204000808000ULL, 0x2860100040024022ULL, 0x0001002004110040ULL, 0x99101042000A0020ULL,
+    0x0004080004008080ULL, 0x0010040002008080ULL, 0x2012004881020004ULL, 0x8300842444820011ULL,
+    0x0088403882010200ULL, 0x0820400080210100ULL, 0x0110910040A00300ULL, 0x0801100280080480ULL,
+    0x0242009008200600ULL, 0x1002000489500200ULL, 0x0040800200010080ULL, 0x0091800041000080ULL,
+    0x0000209300488001ULL, 0x04C1002414824001ULL, 0x020020000B001041ULL, 0x7000100004200901ULL,
+    0x8002002004100802ULL, 0x30010002084C0007ULL, 0x0888221800813004ULL, 0x4000002840840112ULL
+};
+
+// Relevant occupancy mask: the rays from 'sq' without the board edges,
+// since a blocker on the last square of a ray never changes the attack set
+static constexpr Bitboard slider_mask(int sq, const int *deltas) {
+    int r = sq / 8, f = sq % 8;
+    Bitboard edges = ((0xFFULL | 0xFF00000000000000ULL) & ~(0xFFULL << (r * 8))) |
+                     ((0x0101010101010101ULL | 0x8080808080808080ULL) &
+                      ~(0x0101010101010101ULL << f));
+    return sliding_attacks(sq, 0, deltas, 4) & ~edges;
 }
 
-// Generate knight attack table
-static void init_knight_attacks_table() {
-    int knight_d[8][2] = {{2,1},{1,2},{-1,2},{-2,1},{-2,-1},{-1,-2},{1,-2},{2,-1}};
+// Magic entries for one slider; offsets start at 'base' in the shared table
+static constexpr MagicTable make_magics(const Bitboard *magic_numbers,
+    const int *deltas, unsigned base) {
+    MagicTable magics{};
+    unsigned offset = base;
     for (int sq = 0; sq < 64; ++sq) {
-        int r = sq / 8, f = sq % 8;
-        Bitboard b = 0;
-        for (int i = 0; i < 8; ++i) {
-            int nr = r + knight_d[i][0], nf = f + knight_d[i][1];
-            if (nr >= 0 && nr < 8 && nf >= 0 && nf < 8)
-                b |= (1ULL << (nr*8 + nf));
-        }
-        knight_attacks[sq] = b;
+        Magic &m = magics.entry[sq];
+        m.mask = slider_mask(sq, deltas);
+        m.magic = magic_numbers[sq];
+        m.shift = 64 - __builtin_popcountll(m.mask);
+        m.offset = offset;
+        offset += 1u << __builtin_popcountll(m.mask);
     }
+    return magics;
 }
 
-// Generate king attack table
-static void init_king_attacks_table() {
-    int king_d[8][2] = {{1,0},{1,1},{0,1},{-1,1},{-1,0},{-1,-1},{0,-1},{1,-1}};
-    for (int sq = 0; sq < 64; ++sq) {
-        int r = sq / 8, f = sq % 8;
-        Bitboard b = 0;
-        for (int i = 0; i < 8; ++i) {
-            int nr = r + king_d[i][0], nf = f + king_d[i][1];
-            if (nr >= 0 && nr < 8 && nf >= 0 && nf < 8)
-                b |= (1ULL << (nr*8 + nf));
+constexpr MagicTable bishop_magics = make_magics(bishop_magic_numbers, bishop_dirs, 0);
+constexpr MagicTable rook_magics = make_magics(rook_magic_numbers, rook_dirs, 5248);
+
+// Empty-board ray from each square in each of the eight slider directions
+static constexpr int ray_dirs[8] = {9, 7, -9, -7, 8, -8, 1, -1};
+
+// Plain arrays rather than std::array: operator[] calls dominate the
+// compiler's constexpr operation count for a table this size
+struct RayTable {
+    Bitboard ray[8][64];
+};
+
+static constexpr RayTable make_rays() {
+    RayTable t{};
+    for (int d = 0; d < 8; ++d)
+        for (int sq = 0; sq < 64; ++sq)
+            t.ray[d][sq] = sliding_attacks(sq, 0, &ray_dirs[d], 1);
+    return t;
+}
+
+static constexpr RayTable rays = make_rays();
+
+// Same result as sliding_attacks, but cheap enough to evaluate for every
+// table entry at compile time: each ray is cut at its nearest blocker
+static constexpr Bitboard ray_cut_attacks(int sq, Bitboard occ, int first_dir) {
+    Bitboard attacks = 0;
+    for (int d = first_dir; d < first_dir + 4; ++d) {
+        Bitboard ray = rays.ray[d][sq];
+        Bitboard blockers = ray & occ;
+        if (blockers) {
+            // Positive directions hit the lowest blocker first
+            int nearest = ray_dirs[d] > 0 ? __builtin_ctzll(blockers)
+                                          : 63 - __builtin_clzll(blockers);
+            ray ^= rays.ray[d][nearest];
         }
-        king_attacks[sq] = b;
+        attacks |= ray;
     }
+    return attacks;
 }
 
-// Generate pawn attack table for both colors
-static void init_pawn_attacks_table() {
+// Fill the attack table, enumerating every subset of each mask
+// (Carry-Rippler); verify_slider_tables checks it against the ray walker
+static constexpr SliderAttackTable make_slider_attack_table() {
+    SliderAttackTable table{};
     for (int sq = 0; sq < 64; ++sq) {
-        int r = sq / 8, f = sq % 8;
-        Bitboard b = 0;
-        if (r+1 < 8 && f-1 >= 0) b |= (1ULL << ((r+1)*8 + (f-1)));
-        if (r+1 < 8 && f+1 < 8)  b |= (1ULL << ((r+1)*8 + (f+1)));
-        pawn_attacks[WHITE][sq] = b;
-        b = 0;
-        if (r-1 >= 0 && f-1 >= 0) b |= (1ULL << ((r-1)*8 + (f-1)));
-        if (r-1 >= 0 && f+1 < 8)  b |= (1ULL << ((r-1)*8 + (f+1)));
-        pawn_attacks[BLACK][sq] = b;
+        for (int i = 0; i < 2; ++i) {
+            const Magic m = i == 0 ? bishop_magics.entry[sq] : rook_magics.entry[sq];
+            Bitboard occ = 0;
+#if defined(USE_PEXT)
+            unsigned n = 0;
+#endif
+            do {
+#if defined(USE_PEXT)
+                // Carry-Rippler visits the subsets in increasing PEXT index order
+                unsigned index = n++;
+#else
+                unsigned index = unsigned(((occ & m.mask) * m.magic) >> m.shift);
+#endif
+                table.attacks[m.offset + index] = ray_cut_attacks(sq, occ, i == 0 ? 0 : 4);
+                occ = (occ - m.mask) & m.mask;
+            } while (occ);
+        }
     }
+    return table;
 }
 
-// Initialize precomputed attack tables
-void init_attack_tables() {
-    static bool initialized = false;
-    if (initialized) return;
-    initialized = true;
-    init_knight_attacks_table();
-    init_king_attacks_table();
-    init_pawn_attacks_table();
+constexpr SliderAttackTable slider_attack_table = make_slider_attack_table();
+
+bool verify_slider_tables() {
+    for (int sq = 0; sq < 64; ++sq) {
+        const Magic *sets[2] = {&bishop_magics.entry[sq], &rook_magics.entry[sq]};
+        const int *dirs[2] = {bishop_dirs, rook_dirs};
+        for (int i = 0; i < 2; ++i) {
+            Bitboard mask = sets[i]->mask;
+            Bitboard occ = 0;
+            do {
+                // Add blockers outside the mask; they must not affect the result
+                Bitboard full = occ | (~mask & 0x5A3C7E18E7813DA5ULL);
+                Bitboard got = i == 0 ? bishop_attacks(sq, full) : rook_attacks(sq, full);
+                if (got != sliding_attacks(sq, full, dirs[i], 4)) return false;
+                occ = (occ - mask) & mask;
+            } while (occ);
+        }
+    }
+    return true;
 }
 
 } // namespace chess
\ No newline at end of file
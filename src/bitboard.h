@@ -2,6 +2,10 @@
  #define CHESS_BITBOARD_H
 
  #include "types.h"
+ #include <array>
+#if defined(USE_PEXT)
+#include <immintrin.h>
+#endif
 
 namespace chess {
 
@@ -10,6 +14,11 @@ inline int get_lsb_index(Bitboard b) {
     return __builtin_ctzll(b);
 }
 
+// Number of set squares
+inline int popcount(Bitboard b) {
+    return __builtin_popcountll(b);
+}
+
 // Pop least significant bit and return it
 inline Bitboard pop_lsb(Bitboard &b) {
     Bitboard lsb = b & -b;
@@ -17,16 +26,182 @@ inline Bitboard pop_lsb(Bitboard &b) {
     return lsb;
 }
 
-// Generate sliding attacks from square 'sq' in directions 'deltas'
-Bitboard sliding_attacks(int sq, Bitboard occ, const int *deltas, int count);
+constexpr Bitboard FILE_A_BB = 0x0101010101010101ULL;
+constexpr Bitboard FILE_H_BB = FILE_A_BB << 7;
+constexpr Bitboard RANK_1_BB = 0xFFULL;
+
+constexpr Bitboard rank_bb(int rank) {
+    return RANK_1_BB << (8 * rank);
+}
+
+constexpr Bitboard file_bb(int file) {
+    return FILE_A_BB << file;
+}
+
+// Shift every square of 'b' by 'D' (a king-step direction as a square
+// delta), dropping squares that would wrap around the a/h files
+template <int D>
+constexpr Bitboard shift(Bitboard b) {
+    if constexpr (D == 8) return b << 8;
+    else if constexpr (D == -8) return b >> 8;
+    else if constexpr (D == 9) return (b & ~FILE_H_BB) << 9;
+    else if constexpr (D == 7) return (b & ~FILE_A_BB) << 7;
+    else if constexpr (D == -7) return (b & ~FILE_H_BB) >> 7;
+    else if constexpr (D == -9) return (b & ~FILE_A_BB) >> 9;
+    else if constexpr (D == 1) return (b & ~FILE_H_BB) << 1;
+    else {
+        static_assert(D == -1, "shift direction must be a king step");
+        return (b & ~FILE_A_BB) >> 1;
+    }
+}
+
+// Generate sliding attacks from square 'sq' in directions 'deltas'.
+// Reference ray walker; only used to build and verify the magic tables.
+constexpr Bitboard sliding_attacks(int sq, Bitboard occ, const int *deltas, int count) {
+    Bitboard attacks = 0;
+    for (int i = 0; i < count; ++i) {
+        int dir = deltas[i];
+        int s = sq;
+        while (true) {
+            int f = s % 8;
+            bool edge = false;
+            if ((dir == 1 || dir == 9 || dir == -7) && f == 7) edge = true;
+            else if ((dir == -1 || dir == 7 || dir == -9) && f == 0) edge = true;
+            if (edge) break;
+            s += dir;
+            if (s < 0 || s > 63) break;
+            attacks |= (1ULL << s);
+            if (occ & (1ULL << s)) break;
+        }
+    }
+    return attacks;
+}
+
+inline constexpr int bishop_dirs[4] = {9, 7, -9, -7};
+inline constexpr int rook_dirs[4] = {8, -8, 1, -1};
+
+// Attacks of a non-sliding piece from 'sq' given (rank, file) steps
+constexpr Bitboard step_attacks(int sq, const int (*steps)[2], int count) {
+    int r = sq / 8, f = sq % 8;
+    Bitboard b = 0;
+    for (int i = 0; i < count; ++i) {
+        int nr = r + steps[i][0], nf = f + steps[i][1];
+        if (nr >= 0 && nr < 8 && nf >= 0 && nf < 8)
+            b |= (1ULL << (nr*8 + nf));
+    }
+    return b;
+}
+
+using SquareTable = std::array<Bitboard, 64>;
+using SquarePairTable = std::array<SquareTable, 64>;
+
+constexpr SquareTable make_knight_attacks() {
+    constexpr int knight_d[8][2] = {{2,1},{1,2},{-1,2},{-2,1},{-2,-1},{-1,-2},{1,-2},{2,-1}};
+    SquareTable t{};
+    for (int sq = 0; sq < 64; ++sq) t[sq] = step_attacks(sq, knight_d, 8);
+    return t;
+}
+
+constexpr SquareTable make_king_attacks() {
+    constexpr int king_d[8][2] = {{1,0},{1,1},{0,1},{-1,1},{-1,0},{-1,-1},{0,-1},{1,-1}};
+    SquareTable t{};
+    for (int sq = 0; sq < 64; ++sq) t[sq] = step_attacks(sq, king_d, 8);
+    return t;
+}
+
+constexpr std::array<SquareTable, 2> make_pawn_attacks() {
+    constexpr int white_d[2][2] = {{1,-1},{1,1}};
+    constexpr int black_d[2][2] = {{-1,-1},{-1,1}};
+    std::array<SquareTable, 2> t{};
+    for (int sq = 0; sq < 64; ++sq) {
+        t[WHITE][sq] = step_attacks(sq, white_d, 2);
+        t[BLACK][sq] = step_attacks(sq, black_d, 2);
+    }
+    return t;
+}
+
+// Between and line tables from the empty-board slider rays
+constexpr SquarePairTable make_line_table(bool between) {
+    SquarePairTable t{};
+    for (int a = 0; a < 64; ++a) {
+        for (int b = 0; b < 64; ++b) {
+            if (a == b) continue;
+            Bitboard ab = (1ULL << a) | (1ULL << b);
+            // 0: not aligned, 1: diagonal, 2: orthogonal
+            int kind = (sliding_attacks(a, 0, bishop_dirs, 4) & (1ULL << b)) ? 1
+                     : (sliding_attacks(a, 0, rook_dirs, 4) & (1ULL << b))   ? 2
+                                                                              : 0;
+            if (kind == 0) continue;
+            const int *dirs = kind == 1 ? bishop_dirs : rook_dirs;
+            t[a][b] = between
+                ? sliding_attacks(a, 1ULL << b, dirs, 4) & sliding_attacks(b, 1ULL << a, dirs, 4)
+                : (sliding_attacks(a, 0, dirs, 4) & sliding_attacks(b, 0, dirs, 4)) | ab;
+        }
+    }
+    return t;
+}
+
+// Precomputed attack tables, generated at compile time
+inline constexpr SquareTable knight_attacks = make_knight_attacks();
+inline constexpr SquareTable king_attacks = make_king_attacks();
+inline constexpr std::array<SquareTable, 2> pawn_attacks = make_pawn_attacks();
+
+// Squares strictly between two aligned squares (empty if not aligned)
+inline constexpr SquarePairTable between_bb = make_line_table(true);
+// Full board line through two aligned squares (empty if not aligned)
+inline constexpr SquarePairTable line_bb = make_line_table(false);
+
+// Fancy magic entry for one square: relevant occupancy mask, multiplier,
+// shift, and the square's offset into the shared attack table
+struct Magic {
+    Bitboard mask;
+    Bitboard magic;
+    unsigned offset;
+    unsigned shift;
+
+    unsigned index(Bitboard occ) const {
+#if defined(USE_PEXT)
+        return unsigned(_pext_u64(occ, mask));
+#else
+        return unsigned(((occ & mask) * magic) >> shift);
+#endif
+    }
+};
 
-// Initialize attack tables for knight, king, and pawn
-void init_attack_tables();
+struct MagicTable {
+    Magic entry[64];
+};
 
-// Precomputed attack tables
-extern Bitboard knight_attacks[64];
-extern Bitboard king_attacks[64];
-extern Bitboard pawn_attacks[2][64];
+// Bishop entries use the first 5248 slots, rook entries the remaining 102400
+struct SliderAttackTable {
+    Bitboard attacks[5248 + 102400];
+};
+
+// Magic entries and the attack table they index, generated at compile
+// time in bitboard.cpp so the 100k-entry table is built only once
+extern const MagicTable bishop_magics;
+extern const MagicTable rook_magics;
+extern const SliderAttackTable slider_attack_table;
+
+// Check every magic table entry against the reference ray walker
+bool verify_slider_tables();
+
+// Bishop attacks from 'sq' given board occupancy 'occ'
+inline Bitboard bishop_attacks(int sq, Bitboard occ) {
+    const Magic &m = bishop_magics.entry[sq];
+    return slider_attack_table.attacks[m.offset + m.index(occ)];
+}
+
+// Rook attacks from 'sq' given board occupancy 'occ'
+inline Bitboard rook_attacks(int sq, Bitboard occ) {
+    const Magic &m = rook_magics.entry[sq];
+    return slider_attack_table.attacks[m.offset + m.index(occ)];
+}
+
+// Queen attacks from 'sq' given board occupancy 'occ'
+inline Bitboard queen_attacks(int sq, Bitboard occ) {
+    return bishop_attacks(sq, occ) | rook_attacks(sq, occ);
+}
 
 } // namespace chess
 
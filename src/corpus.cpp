@@ -0,0 +1,234 @@
+ #include "corpus.h"
+ #include "bitboard.h"
+ #include "fen.h"
+ #include "suite.h"
+ #include <cstring>
+ #include <istream>
+ #include <ostream>
+ #include <fcntl.h>
+ #include <sys/mman.h>
+ #include <sys/stat.h>
+ #include <unistd.h>
+
+namespace chess {
+
+static constexpr char corpus_magic[4] = {'C', 'P', 'O', 'S'};
+static constexpr uint16_t corpus_version = 1;
+static constexpr size_t writer_buffer_size = 1 << 20;
+
+void pack_position(const Position &pos, PackedPosition &packed) {
+    std::memset(&packed, 0, sizeof(packed));
+    packed.occupied = pos.occupied();
+    Bitboard occ = packed.occupied;
+    for (int i = 0; occ && i < 32; ++i) {
+        int sq = get_lsb_index(pop_lsb(occ));
+        packed.pieces[i / 2] |= uint8_t(pos.board[sq] << (4 * (i & 1)));
+    }
+    packed.state = pos.side_to_move == BLACK ? 1 : 0;
+    packed.state |= uint8_t(pos.castle_rights << 1);
+    packed.ep_file = pos.en_passant < 0 ? 0 : uint8_t(pos.en_passant % 8 + 1);
+    packed.halfmove_clock = pos.halfmove_clock;
+    packed.fullmove_clock = pos.fullmove_clock;
+}
+
+bool unpack_position(const PackedPosition &packed, Position &pos) {
+    if (popcount(packed.occupied) > 32 || packed.ep_file > 8 || packed.state > 31) return false;
+    std::memset(pos.pieces, 0, sizeof(pos.pieces));
+    for (int sq = 0; sq < 64; ++sq) pos.board[sq] = NO_PIECE;
+    Bitboard occ = packed.occupied;
+    for (int i = 0; occ; ++i) {
+        Bitboard b = pop_lsb(occ);
+        int code = (packed.pieces[i / 2] >> (4 * (i & 1))) & 0xF;
+        if (code > BK) return false;
+        pos.pieces[code] |= b;
+        pos.board[get_lsb_index(b)] = Piece(code);
+    }
+    pos.occupancies[WHITE] = pos.pieces[WP] | pos.pieces[WN] | pos.pieces[WB] |
+                             pos.pieces[WR] | pos.pieces[WQ] | pos.pieces[WK];
+    pos.occupancies[BLACK] = pos.pieces[BP] | pos.pieces[BN] | pos.pieces[BB] |
+                             pos.pieces[BR] | pos.pieces[BQ] | pos.pieces[BK];
+    pos.side_to_move = (packed.state & 1) ? BLACK : WHITE;
+    pos.castle_rights = uint8_t(packed.state >> 1);
+    // The ep square is behind the pawn that just moved, so the rank follows
+    // from the side to move
+    pos.en_passant = int8_t(packed.ep_file == 0 ? -1
+        : (pos.side_to_move == WHITE ? 40 : 16) + packed.ep_file - 1);
+    pos.halfmove_clock = packed.halfmove_clock;
+    pos.fullmove_clock = packed.fullmove_clock;
+    // The same checks as a FEN, so no illegal record reaches the generator
+    if (validate_position(pos) != FenError::None) return false;
+    drop_dead_en_passant(pos);
+    pos.key = compute_key(pos);
+    update_check_info(pos);
+    return true;
+}
+
+CorpusWriter::~CorpusWriter() {
+    close();
+}
+
+bool CorpusWriter::open(const std::string &path, CorpusPayload payload, bool append) {
+    close();
+    record_size_ = sizeof(PackedPosition) + (payload == CorpusPayload::None ? 0 : 8);
+    // Append to an existing corpus only if its layout matches
+    std::ifstream existing;
+    if (append) existing.open(path, std::ios::binary);
+    CorpusHeader header;
+    if (append && existing.read(reinterpret_cast<char *>(&header), sizeof(header))) {
+        if (std::memcmp(header.magic, corpus_magic, 4) != 0 ||
+            header.version != corpus_version || header.payload != payload ||
+            header.record_size != record_size_)
+            return false;
+        existing.close();
+        file_.open(path, std::ios::binary | std::ios::app);
+    } else {
+        existing.close();
+        file_.open(path, std::ios::binary | std::ios::trunc);
+        std::memset(&header, 0, sizeof(header));
+        std::memcpy(header.magic, corpus_magic, 4);
+        header.version = corpus_version;
+        header.record_size = uint16_t(record_size_);
+        header.payload = payload;
+        file_.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    }
+    buffer_.resize(writer_buffer_size - writer_buffer_size % record_size_);
+    used_ = 0;
+    written_ = 0;
+    return bool(file_);
+}
+
+bool CorpusWriter::append(const Position &pos, uint64_t payload) {
+    PackedPosition packed;
+    pack_position(pos, packed);
+    return append(packed, payload);
+}
+
+bool CorpusWriter::append(const PackedPosition &packed, uint64_t payload) {
+    if (!file_.is_open()) return false;
+    if (used_ + record_size_ > buffer_.size() && !flush()) return false;
+    std::memcpy(&buffer_[used_], &packed, sizeof(packed));
+    if (record_size_ > sizeof(packed))
+        std::memcpy(&buffer_[used_ + sizeof(packed)], &payload, sizeof(payload));
+    used_ += record_size_;
+    ++written_;
+    return true;
+}
+
+bool CorpusWriter::flush() {
+    if (!file_.is_open()) return false;
+    file_.write(buffer_.data(), std::streamsize(used_));
+    used_ = 0;
+    file_.flush();
+    return bool(file_);
+}
+
+bool CorpusWriter::close() {
+    if (!file_.is_open()) return true;
+    bool ok = flush();
+    file_.close();
+    return ok;
+}
+
+CorpusReader::~CorpusReader() {
+    close();
+}
+
+bool CorpusReader::open(const std::string &path) {
+    close();
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) return false;
+    struct stat st;
+    if (fstat(fd, &st) != 0 || size_t(st.st_size) < sizeof(CorpusHeader)) {
+        ::close(fd);
+        return false;
+    }
+    void *map = mmap(nullptr, size_t(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (map == MAP_FAILED) return false;
+    map_ = static_cast<const unsigned char *>(map);
+    map_size_ = size_t(st.st_size);
+    madvise(map, map_size_, MADV_SEQUENTIAL);
+
+    std::memcpy(&header_, map_, sizeof(header_));
+    size_t expected = sizeof(PackedPosition) +
+                      (header_.payload == CorpusPayload::None ? 0 : sizeof(uint64_t));
+    if (std::memcmp(header_.magic, corpus_magic, 4) != 0 || header_.version != corpus_version ||
+        header_.record_size != expected) {
+        close();
+        return false;
+    }
+    records_ = map_ + sizeof(CorpusHeader);
+    count_ = (map_size_ - sizeof(CorpusHeader)) / header_.record_size;
+    return true;
+}
+
+void CorpusReader::close() {
+    if (map_) munmap(const_cast<unsigned char *>(map_), map_size_);
+    map_ = records_ = nullptr;
+    map_size_ = count_ = 0;
+}
+
+uint64_t CorpusReader::payload(size_t i) const {
+    if (header_.payload == CorpusPayload::None) return 0;
+    uint64_t value;
+    std::memcpy(&value, records_ + i * header_.record_size + sizeof(PackedPosition),
+                sizeof(value));
+    return value;
+}
+
+PositionFormat position_format_for(const std::string &path) {
+    if (path.empty()) return PositionFormat::None;
+    bool binary = path.size() > 5 && path.compare(path.size() - 5, 5, ".cpos") == 0;
+    return binary ? PositionFormat::Corpus : PositionFormat::Fen;
+}
+
+bool convert_to_corpus(std::istream &in, const std::string &path, std::ostream &log) {
+    CorpusWriter writer;
+    bool opened = false, ok = true;
+    std::string text;
+    int line = 0;
+    while (std::getline(in, text)) {
+        ++line;
+        EpdEntry entry;
+        bool parsed = parse_epd_line(text, entry);
+        if (parsed && entry.fen.empty()) continue;
+        // Plain FEN lines have no depth fields, which is fine here
+        if (!parsed && entry.expected.empty() && !entry.fen.empty()) parsed = true;
+        Position pos;
+        FenError err = parsed ? parse_fen(entry.fen, pos) : FenError::None;
+        if (!parsed || err != FenError::None) {
+            log << "line " << line << ": skipped invalid record";
+            if (parsed) log << " (" << fen_error_string(err) << ")";
+            log << ": " << text << "\n";
+            ok = false;
+            continue;
+        }
+        // The first record decides whether the file carries perft counts
+        if (!opened) {
+            CorpusPayload kind = entry.expected.empty() ? CorpusPayload::None
+                                                        : CorpusPayload::PerftCount;
+            if (!writer.open(path, kind)) {
+                log << "cannot write corpus: " << path << "\n";
+                return false;
+            }
+            opened = true;
+        }
+        uint64_t payload = 0;
+        if (!entry.expected.empty())
+            payload = make_perft_payload(entry.expected.back().first, entry.expected.back().second);
+        writer.append(pos, payload);
+    }
+    if (!opened && !writer.open(path, CorpusPayload::None)) {
+        log << "cannot write corpus: " << path << "\n";
+        return false;
+    }
+    uint64_t written = writer.records_written();
+    if (!writer.close()) {
+        log << "error writing corpus: " << path << "\n";
+        return false;
+    }
+    log << "Wrote " << written << " records to " << path << "\n";
+    return ok;
+}
+
+} // namespace chess
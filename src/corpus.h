@@ -0,0 +1,124 @@
+ #ifndef CHESS_CORPUS_H
+ #define CHESS_CORPUS_H
+
+ #include "position.h"
+ #include <cstddef>
+ #include <cstdint>
+ #include <fstream>
+ #include <iosfwd>
+ #include <string>
+ #include <vector>
+
+namespace chess {
+
+// Fixed-size binary encoding of a Position (32 bytes). Piece codes for
+// the occupied squares are packed two per byte, in ascending square
+// order, so 16 bytes cover up to 32 pieces. All fields are little-endian.
+struct PackedPosition {
+    uint64_t occupied;
+    uint8_t pieces[16];
+    uint8_t state;      // bit 0 black to move, bits 1-4 castle rights KQkq
+    uint8_t ep_file;    // 0 when there is no en passant square, else file + 1
+    uint16_t halfmove_clock;
+    uint16_t fullmove_clock;
+    uint16_t reserved;
+};
+static_assert(sizeof(PackedPosition) == 32, "PackedPosition must stay 32 bytes");
+
+// What the optional 8-byte value after each record holds
+enum class CorpusPayload : uint32_t {
+    None = 0,
+    PerftCount = 1,  // depth in the top 8 bits, leaf count in the low 56
+    Score = 2,       // signed 64-bit score
+};
+
+// Corpus file: this header, then records of 'record_size' bytes (32, or
+// 40 with a payload). The record count follows from the file size.
+struct CorpusHeader {
+    char magic[4];       // "CPOS"
+    uint16_t version;
+    uint16_t record_size;
+    CorpusPayload payload;
+    uint32_t reserved;
+};
+static_assert(sizeof(CorpusHeader) == 16, "CorpusHeader must stay 16 bytes");
+
+void pack_position(const Position &pos, PackedPosition &packed);
+// Decode a record into a full Position; returns false on a corrupt record
+// or one that fails the checks parse_fen applies
+bool unpack_position(const PackedPosition &packed, Position &pos);
+
+constexpr uint64_t make_perft_payload(int depth, uint64_t nodes) {
+    return (uint64_t(depth) << 56) | (nodes & ((1ULL << 56) - 1));
+}
+constexpr int perft_payload_depth(uint64_t payload) { return int(payload >> 56); }
+constexpr uint64_t perft_payload_nodes(uint64_t payload) {
+    return payload & ((1ULL << 56) - 1);
+}
+
+// Writes records through a fixed buffer. The file is replaced unless
+// 'append' is set and it already holds a corpus with the same payload kind.
+class CorpusWriter {
+public:
+    ~CorpusWriter();
+    bool open(const std::string &path, CorpusPayload payload, bool append = false);
+    bool append(const Position &pos, uint64_t payload = 0);
+    bool append(const PackedPosition &packed, uint64_t payload = 0);
+    bool flush();
+    bool close();
+    uint64_t records_written() const { return written_; }
+
+private:
+    std::ofstream file_;
+    std::vector<char> buffer_;
+    size_t used_ = 0;
+    size_t record_size_ = 0;
+    uint64_t written_ = 0;
+};
+
+// Maps a corpus file read-only and hands out records in place
+class CorpusReader {
+public:
+    CorpusReader() = default;
+    CorpusReader(const CorpusReader &) = delete;
+    CorpusReader &operator=(const CorpusReader &) = delete;
+    ~CorpusReader();
+
+    bool open(const std::string &path);
+    void close();
+
+    size_t size() const { return count_; }
+    CorpusPayload payload_kind() const { return header_.payload; }
+    const PackedPosition &record(size_t i) const {
+        return *reinterpret_cast<const PackedPosition *>(records_ + i * header_.record_size);
+    }
+    uint64_t payload(size_t i) const;
+    bool read(size_t i, Position &pos) const { return unpack_position(record(i), pos); }
+
+private:
+    const unsigned char *map_ = nullptr;
+    size_t map_size_ = 0;
+    const unsigned char *records_ = nullptr;
+    size_t count_ = 0;
+    CorpusHeader header_{};
+};
+
+// How tools that extract positions write them
+enum class PositionFormat {
+    None,    // count only
+    Fen,     // one FEN per line
+    Corpus,  // binary corpus records
+};
+
+// Corpus for a ".cpos" path, FEN for any other, None for an empty one
+PositionFormat position_format_for(const std::string &path);
+
+// Convert FEN or EPD lines to a corpus. If the first record has
+// ";D<n> <count>" fields, every record stores its deepest count as a
+// PerftCount payload (0 when a line has none). Invalid lines are reported
+// to 'log' and skipped; returns false if any were.
+bool convert_to_corpus(std::istream &in, const std::string &path, std::ostream &log);
+
+} // namespace chess
+
+#endif // CHESS_CORPUS_H
@@ -0,0 +1,117 @@
+ #include "evaluate.h"
+ #include "bitboard.h"
+
+namespace chess {
+
+// Piece-square tables from White's point of view, a1 = index 0. Black
+// reads them with the square flipped vertically.
+static constexpr int pawn_table[64] = {
+     0,  0,  0,  0,  0,  0,  0,  0,
+     5, 10, 10,-20,-20, 10, 10,  5,
+     5, -5,-10,  0,  0,-10, -5,  5,
+     0,  0,  0, 20, 20,  0,  0,  0,
+     5,  5, 10, 25, 25, 10,  5,  5,
+    10, 10, 20, 30, 30, 20, 10, 10,
+    50, 50, 50, 50, 50, 50, 50, 50,
+     0,  0,  0,  0,  0,  0,  0,  0,
+};
+
+static constexpr int knight_table[64] = {
+    -50,-40,-30,-30,-30,-30,-40,-50,
+    -40,-20,  0,  5,  5,  0,-20,-40,
+    -30,  5, 10, 15, 15, 10,  5,-30,
+    -30,  0, 15, 20, 20, 15,  0,-30,
+    -30,  5, 15, 20, 20, 15,  5,-30,
+    -30,  0, 10, 15, 15, 10,  0,-30,
+    -40,-20,  0,  0,  0,  0,-20,-40,
+    -50,-40,-30,-30,-30,-30,-40,-50,
+};
+
+static constexpr int bishop_table[64] = {
+    -20,-10,-10,-10,-10,-10,-10,-20,
+    -10,  5,  0,  0,  0,  0,  5,-10,
+    -10, 10, 10, 10, 10, 10, 10,-10,
+    -10,  0, 10, 10, 10, 10,  0,-10,
+    -10,  5,  5, 10, 10,  5,  5,-10,
+    -10,  0,  5, 10, 10,  5,  0,-10,
+    -10,  0,  0,  0,  0,  0,  0,-10,
+    -20,-10,-10,-10,-10,-10,-10,-20,
+};
+
+static constexpr int rook_table[64] = {
+     0,  0,  0,  5,  5,  0,  0,  0,
+    -5,  0,  0,  0,  0,  0,  0, -5,
+    -5,  0,  0,  0,  0,  0,  0, -5,
+    -5,  0,  0,  0,  0,  0,  0, -5,
+    -5,  0,  0,  0,  0,  0,  0, -5,
+    -5,  0,  0,  0,  0,  0,  0, -5,
+     5, 10, 10, 10, 10, 10, 10,  5,
+     0,  0,  0,  0,  0,  0,  0,  0,
+};
+
+static constexpr int queen_table[64] = {
+    -20,-10,-10, -5, -5,-10,-10,-20,
+    -10,  0,  5,  0,  0,  0,  0,-10,
+    -10,  5,  5,  5,  5,  5,  0,-10,
+      0,  0,  5,  5,  5,  5,  0, -5,
+     -5,  0,  5,  5,  5,  5,  0, -5,
+    -10,  0,  5,  5,  5,  5,  0,-10,
+    -10,  0,  0,  0,  0,  0,  0,-10,
+    -20,-10,-10, -5, -5,-10,-10,-20,
+};
+
+static constexpr int king_mg_table[64] = {
+     20, 30, 10,  0,  0, 10, 30, 20,
+     20, 20,  0,  0,  0,  0, 20, 20,
+    -10,-20,-20,-20,-20,-20,-20,-10,
+    -20,-30,-30,-40,-40,-30,-30,-20,
+    -30,-40,-40,-50,-50,-40,-40,-30,
+    -30,-40,-40,-50,-50,-40,-40,-30,
+    -30,-40,-40,-50,-50,-40,-40,-30,
+    -30,-40,-40,-50,-50,-40,-40,-30,
+};
+
+static constexpr int king_eg_table[64] = {
+    -50,-30,-30,-30,-30,-30,-30,-50,
+    -30,-30,  0,  0,  0,  0,-30,-30,
+    -30,-10, 20, 30, 30, 20,-10,-30,
+    -30,-10, 30, 40, 40, 30,-10,-30,
+    -30,-10, 30, 40, 40, 30,-10,-30,
+    -30,-10, 20, 30, 30, 20,-10,-30,
+    -30,-20,-10,  0,  0,-10,-20,-30,
+    -50,-40,-30,-20,-20,-30,-40,-50,
+};
+
+static constexpr const int *piece_tables[5] = {
+    pawn_table, knight_table, bishop_table, rook_table, queen_table,
+};
+
+// Non-pawn material at which the king table is fully middlegame
+static constexpr int opening_material = 2 * (2 * 320 + 2 * 330 + 2 * 500 + 900);
+
+int evaluate(const Position &pos) {
+    int score[2] = {0, 0};
+    int material = 0;
+    for (int c = WHITE; c <= BLACK; ++c) {
+        int flip = c == WHITE ? 0 : 56;
+        for (int pt = PAWN; pt <= QUEEN; ++pt) {
+            Bitboard b = pos.pieces[make_piece(Color(c), PieceType(pt))];
+            if (pt != PAWN) material += popcount(b) * piece_value[pt];
+            while (b) {
+                int sq = get_lsb_index(pop_lsb(b));
+                score[c] += piece_value[pt] + piece_tables[pt][sq ^ flip];
+            }
+        }
+    }
+    // Blend the king tables by the material left on the board
+    int phase = material < opening_material ? material : opening_material;
+    for (int c = WHITE; c <= BLACK; ++c) {
+        int sq = get_lsb_index(pos.pieces[make_piece(Color(c), KING)]) ^ (c == WHITE ? 0 : 56);
+        score[c] += (king_mg_table[sq] * phase + king_eg_table[sq] * (opening_material - phase)) /
+                    opening_material;
+    }
+    int white = score[WHITE] - score[BLACK];
+    return pos.side_to_move == WHITE ? white : -white;
+}
+
+} // namespace chess
@@ -0,0 +1,18 @@
+ #ifndef CHESS_EVALUATE_H
+ #define CHESS_EVALUATE_H
+
+ #include "position.h"
+
+namespace chess {
+
+// Centipawn value of each piece type, indexed by PieceType
+constexpr int piece_value[6] = {100, 320, 330, 500, 900, 0};
+
+// Static evaluation in centipawns from the side to move's point of view:
+// material plus piece-square tables, with the king table blended from
+// middlegame to endgame as non-pawn material comes off.
+int evaluate(const Position &pos);
+
+} // namespace chess
+
+#endif // CHESS_EVALUATE_H
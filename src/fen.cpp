@@ -0,0 +1,267 @@
+ #include "fen.h"
+ #include "bitboard.h"
+ #include "movegen.h"
+ #include <cstring>
+
+namespace chess {
+
+const char *fen_error_string(FenError err) {
+    switch (err) {
+        case FenError::None: return "ok";
+        case FenError::Placement: return "bad piece placement";
+        case FenError::SideToMove: return "bad side to move";
+        case FenError::Castling: return "bad castling field";
+        case FenError::EnPassant: return "bad en passant field";
+        case FenError::Clocks: return "bad move clocks";
+        case FenError::TrailingData: return "trailing data";
+        case FenError::KingCount: return "wrong number of kings";
+        case FenError::TooManyPieces: return "too many pieces";
+        case FenError::PawnOnBackRank: return "pawn on first or last rank";
+        case FenError::CastlingRights: return "castling right without king and rook";
+        case FenError::EnPassantSquare: return "en passant square without double push";
+        case FenError::OpponentInCheck: return "side not to move is in check";
+    }
+    return "unknown error";
+}
+
+// Piece for each FEN letter; NO_PIECE for anything else
+struct PieceLetters {
+    Piece piece[256];
+};
+
+static constexpr PieceLetters make_piece_letters() {
+    PieceLetters t{};
+    for (int c = 0; c < 256; ++c) t.piece[c] = NO_PIECE;
+    const char letters[] = "PNBRQKpnbrqk";
+    for (int p = WP; p <= BK; ++p) t.piece[static_cast<unsigned char>(letters[p])] = Piece(p);
+    return t;
+}
+
+static constexpr PieceLetters piece_letters = make_piece_letters();
+static constexpr char piece_chars[] = "PNBRQKpnbrqk";
+
+static inline bool is_space(char c) { return c == ' ' || c == '\t' || c == '\r'; }
+
+static inline void skip_spaces(const char *&p, const char *end) {
+    while (p < end && is_space(*p)) ++p;
+}
+
+// Parse a non-negative decimal that fits in 31 bits
+static bool parse_uint(const char *&p, const char *end, int &value) {
+    const char *start = p;
+    long v = 0;
+    while (p < end && *p >= '0' && *p <= '9') {
+        v = v * 10 + (*p++ - '0');
+        if (v > 0x7FFFFFFF) return false;
+    }
+    value = int(v);
+    return p != start;
+}
+
+FenError validate_position(const Position &pos) {
+    if (popcount(pos.pieces[WK]) != 1 || popcount(pos.pieces[BK]) != 1)
+        return FenError::KingCount;
+    if (popcount(pos.occupancies[WHITE]) > 16 || popcount(pos.occupancies[BLACK]) > 16 ||
+        popcount(pos.pieces[WP]) > 8 || popcount(pos.pieces[BP]) > 8)
+        return FenError::TooManyPieces;
+    if ((pos.pieces[WP] | pos.pieces[BP]) & (RANK_1_BB | rank_bb(7)))
+        return FenError::PawnOnBackRank;
+
+    // King on its home square and the rook in its corner for each right
+    static constexpr int king_sq[4] = {4, 4, 60, 60};
+    static constexpr int rook_sq[4] = {7, 0, 63, 56};
+    for (int i = 0; i < 4; ++i) {
+        if (!pos.has_castle_right(i)) continue;
+        Piece king = i < 2 ? WK : BK, rook = i < 2 ? WR : BR;
+        if (pos.board[king_sq[i]] != king || pos.board[rook_sq[i]] != rook)
+            return FenError::CastlingRights;
+    }
+
+    // The pawn that just moved two squares sits in front of the ep square
+    if (pos.en_passant >= 0) {
+        int ep = pos.en_passant;
+        bool white = pos.side_to_move == WHITE;
+        int pawn_sq = white ? ep - 8 : ep + 8;
+        int from_sq = white ? ep + 8 : ep - 8;
+        if (ep / 8 != (white ? 5 : 2) || pos.board[pawn_sq] != (white ? BP : WP) ||
+            pos.board[ep] != NO_PIECE || pos.board[from_sq] != NO_PIECE)
+            return FenError::EnPassantSquare;
+    }
+
+    Color us = pos.side_to_move, them = us == WHITE ? BLACK : WHITE;
+    int their_king = get_lsb_index(pos.pieces[them == WHITE ? WK : BK]);
+    if (is_square_attacked(pos, their_king, us)) return FenError::OpponentInCheck;
+    return FenError::None;
+}
+
+FenError parse_fen(std::string_view fen, Position &pos) {
+    const char *p = fen.data(), *end = p + fen.size();
+    skip_spaces(p, end);
+
+    // Piece placement: ranks 8 to 1, filling the mailbox and bitboards together
+    std::memset(pos.pieces, 0, sizeof(pos.pieces));
+    for (int sq = 0; sq < 64; ++sq) pos.board[sq] = NO_PIECE;
+    int rank = 7, file = 0;
+    for (; p < end && !is_space(*p); ++p) {
+        char c = *p;
+        if (c == '/') {
+            if (file != 8 || rank == 0) return FenError::Placement;
+            --rank;
+            file = 0;
+        } else if (c >= '1' && c <= '8') {
+            file += c - '0';
+            if (file > 8) return FenError::Placement;
+        } else {
+            Piece pc = piece_letters.piece[static_cast<unsigned char>(c)];
+            if (pc == NO_PIECE || file > 7) return FenError::Placement;
+            int sq = rank * 8 + file++;
+            pos.pieces[pc] |= 1ULL << sq;
+            pos.board[sq] = pc;
+        }
+    }
+    if (rank != 0 || file != 8) return FenError::Placement;
+    pos.occupancies[WHITE] = pos.pieces[WP] | pos.pieces[WN] | pos.pieces[WB] |
+                             pos.pieces[WR] | pos.pieces[WQ] | pos.pieces[WK];
+    pos.occupancies[BLACK] = pos.pieces[BP] | pos.pieces[BN] | pos.pieces[BB] |
+                             pos.pieces[BR] | pos.pieces[BQ] | pos.pieces[BK];
+
+    // Side to move
+    skip_spaces(p, end);
+    if (p == end || (*p != 'w' && *p != 'b') || (p + 1 < end && !is_space(p[1])))
+        return FenError::SideToMove;
+    pos.side_to_move = *p++ == 'w' ? WHITE : BLACK;
+
+    // Castling rights: '-' or a subset of "KQkq" without repeats
+    skip_spaces(p, end);
+    pos.castle_rights = 0;
+    if (p < end && *p == '-') {
+        ++p;
+    } else {
+        static constexpr char rights[] = "KQkq";
+        const char *start = p;
+        for (; p < end && !is_space(*p); ++p) {
+            const char *r = static_cast<const char *>(std::memchr(rights, *p, 4));
+            if (!r || pos.has_castle_right(int(r - rights))) return FenError::Castling;
+            pos.castle_rights |= uint8_t(1 << (r - rights));
+        }
+        if (p == start) return FenError::Castling;
+    }
+    if (p < end && !is_space(*p)) return FenError::Castling;
+
+    // En passant target
+    skip_spaces(p, end);
+    if (p < end && *p == '-') {
+        pos.en_passant = -1;
+        ++p;
+    } else {
+        if (end - p < 2 || p[0] < 'a' || p[0] > 'h' || p[1] < '1' || p[1] > '8')
+            return FenError::EnPassant;
+        pos.en_passant = int8_t((p[1] - '1') * 8 + (p[0] - 'a'));
+        p += 2;
+    }
+    if (p < end && !is_space(*p)) return FenError::EnPassant;
+
+    // Optional halfmove and fullmove clocks
+    skip_spaces(p, end);
+    pos.halfmove_clock = 0;
+    pos.fullmove_clock = 1;
+    if (p < end) {
+        int halfmove, fullmove;
+        if (!parse_uint(p, end, halfmove) || p == end || !is_space(*p))
+            return FenError::Clocks;
+        skip_spaces(p, end);
+        if (!parse_uint(p, end, fullmove) || halfmove > 0xFFFF || fullmove > 0xFFFF)
+            return FenError::Clocks;
+        pos.halfmove_clock = uint16_t(halfmove);
+        pos.fullmove_clock = uint16_t(fullmove);
+        skip_spaces(p, end);
+        if (p != end) return FenError::TrailingData;
+    }
+
+    FenError err = validate_position(pos);
+    if (err != FenError::None) return err;
+    drop_dead_en_passant(pos);
+    pos.key = compute_key(pos);
+    update_check_info(pos);
+    return FenError::None;
+}
+
+// Append the decimal digits of 'v'
+static inline char *write_uint(char *out, unsigned v) {
+    char digits[10];
+    int n = 0;
+    do {
+        digits[n++] = char('0' + v % 10);
+        v /= 10;
+    } while (v);
+    while (n) *out++ = digits[--n];
+    return out;
+}
+
+size_t write_fen(const Position &pos, char *buf, size_t size) {
+    if (size < FEN_BUFFER_SIZE) {
+        // Write to scratch space first so a short buffer is never overrun
+        char tmp[FEN_BUFFER_SIZE];
+        size_t len = write_fen(pos, tmp, sizeof(tmp));
+        if (len + 1 > size) return 0;
+        std::memcpy(buf, tmp, len + 1);
+        return len;
+    }
+    char *out = buf;
+    for (int rank = 7; rank >= 0; --rank) {
+        int empty = 0;
+        for (int sq = rank * 8; sq < rank * 8 + 8; ++sq) {
+            Piece pc = pos.board[sq];
+            if (pc == NO_PIECE) {
+                ++empty;
+                continue;
+            }
+            if (empty) *out++ = char('0' + empty);
+            empty = 0;
+            *out++ = piece_chars[pc];
+        }
+        if (empty) *out++ = char('0' + empty);
+        if (rank) *out++ = '/';
+    }
+    *out++ = ' ';
+    *out++ = pos.side_to_move == WHITE ? 'w' : 'b';
+    *out++ = ' ';
+    char *rights = out;
+    for (int i = 0; i < 4; ++i)
+        if (pos.has_castle_right(i)) *out++ = "KQkq"[i];
+    if (out == rights) *out++ = '-';
+    *out++ = ' ';
+    if (pos.en_passant < 0) {
+        *out++ = '-';
+    } else {
+        *out++ = char('a' + pos.en_passant % 8);
+        *out++ = char('1' + pos.en_passant / 8);
+    }
+    *out++ = ' ';
+    out = write_uint(out, unsigned(pos.halfmove_clock));
+    *out++ = ' ';
+    out = write_uint(out, unsigned(pos.fullmove_clock));
+    *out = '\0';
+    return size_t(out - buf);
+}
+
+size_t parse_fen_lines(std::string_view text, Position *positions, FenError *errors,
+    size_t capacity) {
+    size_t count = 0;
+    const char *p = text.data(), *end = p + text.size();
+    while (p < end && count < capacity) {
+        const char *eol = static_cast<const char *>(std::memchr(p, '\n', size_t(end - p)));
+        if (!eol) eol = end;
+        const char *q = p;
+        skip_spaces(q, eol);
+        if (q != eol) {
+            FenError err = parse_fen(std::string_view(q, size_t(eol - q)), positions[count]);
+            if (errors) errors[count] = err;
+            ++count;
+        }
+        p = eol + 1;
+    }
+    return count;
+}
+
+} // namespace chess
@@ -0,0 +1,55 @@
+ #ifndef CHESS_FEN_H
+ #define CHESS_FEN_H
+
+ #include "position.h"
+ #include <cstddef>
+ #include <string_view>
+
+namespace chess {
+
+enum class FenError {
+    None,
+    Placement,          // bad piece letter, rank length or rank count
+    SideToMove,
+    Castling,
+    EnPassant,
+    Clocks,
+    TrailingData,
+    KingCount,          // each side needs exactly one king
+    TooManyPieces,      // more than 16 pieces or 8 pawns for a side
+    PawnOnBackRank,
+    CastlingRights,     // right held without king and rook on their squares
+    EnPassantSquare,    // ep square inconsistent with a double push
+    OpponentInCheck,    // the side that just moved left its king attacked
+};
+
+// Short description of a parse error, e.g. "wrong number of kings"
+const char *fen_error_string(FenError err);
+
+// Parse a FEN in one pass without allocating. The move clocks may be
+// omitted (EPD style) and default to "0 1"; surrounding whitespace and a
+// trailing '\r' are ignored. On error 'pos' is left unspecified.
+FenError parse_fen(std::string_view fen, Position &pos);
+
+// The consistency checks parse_fen applies (KingCount onward) to a
+// position whose pieces, occupancies, castle rights and en passant square
+// are set; the key and check info are not used
+FenError validate_position(const Position &pos);
+
+// Large enough for any position
+constexpr size_t FEN_BUFFER_SIZE = 128;
+
+// Write the FEN of 'pos' into 'buf' followed by a NUL. Returns the length
+// without the NUL, or 0 if it does not fit in 'size' bytes.
+size_t write_fen(const Position &pos, char *buf, size_t size);
+
+// Parse a newline-delimited buffer of FENs, skipping blank lines. Line i
+// of the non-blank lines fills positions[i] and, if 'errors' is non-null,
+// errors[i]; invalid lines keep their slot so results stay aligned with
+// the input. Stops after 'capacity' lines and returns the slots filled.
+size_t parse_fen_lines(std::string_view text, Position *positions, FenError *errors,
+    size_t capacity);
+
+} // namespace chess
+
+#endif // CHESS_FEN_H
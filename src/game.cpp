@@ -0,0 +1,102 @@
+ #include "game.h"
+ #include "bitboard.h"
+ #include "movegen.h"
+ #include <algorithm>
+
+namespace chess {
+
+const char *game_end_string(GameEnd end) {
+    switch (end) {
+        case GameEnd::Checkmate: return "checkmate";
+        case GameEnd::Stalemate: return "stalemate";
+        case GameEnd::FiftyMoves: return "fifty-move rule";
+        case GameEnd::Repetition: return "threefold repetition";
+        case GameEnd::InsufficientMaterial: return "insufficient material";
+        default: return "ongoing";
+    }
+}
+
+// Squares of one color: b1, d1, ... (the a1-h8 diagonal is dark)
+static constexpr Bitboard light_squares = 0x55AA55AA55AA55AAULL;
+
+bool has_insufficient_material(const Position &pos) {
+    if (pos.pieces[WP] | pos.pieces[BP] | pos.pieces[WR] | pos.pieces[BR] | pos.pieces[WQ] |
+        pos.pieces[BQ])
+        return false;
+    Bitboard knights = pos.pieces[WN] | pos.pieces[BN];
+    Bitboard bishops = pos.pieces[WB] | pos.pieces[BB];
+    if (popcount(knights | bishops) <= 1) return true;
+    return !knights && (!(bishops & light_squares) || !(bishops & ~light_squares));
+}
+
+Game::Game() {
+    Position start;
+    init_position(start);
+    reset(start);
+}
+
+Game::Game(const Position &start) {
+    reset(start);
+}
+
+void Game::reset(const Position &start) {
+    pos_ = start;
+    states_.clear();
+    states_.push_back({pos_.key, 0, Move(0, 0), {}});
+}
+
+void Game::play(Move m) {
+    State &from = states_.back();
+    from.move = m;
+    make_move(pos_, m, from.undo);
+    // Only positions with the same side to move since the last capture or
+    // pawn move can repeat; the nearest match already counts the ones
+    // before it
+    int n = int(states_.size());
+    int stop = std::max(0, n - int(pos_.halfmove_clock));
+    int repetitions = 0;
+    for (int i = n - 2; i >= stop; i -= 2) {
+        if (states_[i].key == pos_.key) {
+            repetitions = states_[i].repetitions + 1;
+            break;
+        }
+    }
+    states_.push_back({pos_.key, repetitions, Move(0, 0), {}});
+}
+
+bool Game::undo() {
+    if (states_.size() < 2) return false;
+    states_.pop_back();
+    State &s = states_.back();
+    unmake_move(pos_, s.move, s.undo);
+    s.move = Move(0, 0);
+    return true;
+}
+
+std::vector<uint64_t> Game::recent_keys() const {
+    size_t n = ply();
+    size_t first = n - std::min<size_t>(n, pos_.halfmove_clock);
+    std::vector<uint64_t> keys;
+    keys.reserve(n - first);
+    for (size_t i = first; i < n; ++i) keys.push_back(states_[i].key);
+    return keys;
+}
+
+bool Game::is_checkmate() const {
+    return in_check(pos_) && count_legal_moves(pos_) == 0;
+}
+
+bool Game::is_stalemate() const {
+    return !in_check(pos_) && count_legal_moves(pos_) == 0;
+}
+
+GameEnd Game::end(int legal_moves) const {
+    if (legal_moves < 0) legal_moves = count_legal_moves(pos_);
+    if (legal_moves == 0) return in_check(pos_) ? GameEnd::Checkmate : GameEnd::Stalemate;
+    if (is_fifty_moves()) return GameEnd::FiftyMoves;
+    if (is_threefold()) return GameEnd::Repetition;
+    if (has_insufficient_material(pos_)) return GameEnd::InsufficientMaterial;
+    return GameEnd::Ongoing;
+}
+
+} // namespace chess
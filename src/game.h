@@ -0,0 +1,81 @@
+ #ifndef CHESS_GAME_H
+ #define CHESS_GAME_H
+
+ #include "position.h"
+ #include "types.h"
+ #include <cstddef>
+ #include <cstdint>
+ #include <vector>
+
+namespace chess {
+
+// How a game stands under the rules; anything but Ongoing is final
+enum class GameEnd : uint8_t {
+    Ongoing,
+    Checkmate,
+    Stalemate,
+    FiftyMoves,
+    Repetition,            // threefold
+    InsufficientMaterial,  // neither side can mate
+};
+constexpr int GAME_END_COUNT = 6;
+
+// Short description, e.g. "threefold repetition"
+const char *game_end_string(GameEnd end);
+
+// Neither side has mating material: bare kings, a single minor piece, or
+// only bishops that all stand on squares of one color
+bool has_insufficient_material(const Position &pos);
+
+// A position with the moves that led to it. Every ply keeps its key, the
+// undo record of the move played from it, and how often its position
+// occurred before since the last capture or pawn move. That count is found
+// when the move is played, by scanning the same side's earlier keys back
+// to the first match, so repetition queries are O(1).
+class Game {
+public:
+    Game();
+    explicit Game(const Position &start);
+
+    // Start over from 'start', keeping the history's capacity
+    void reset(const Position &start);
+    void play(Move m);
+    // Take back the last move; false if there is none
+    bool undo();
+
+    const Position &position() const { return pos_; }
+    // Moves played since the start position
+    size_t ply() const { return states_.size() - 1; }
+    Move move(size_t i) const { return states_[i].move; }
+    // Keys of the positions before the current one since the last capture
+    // or pawn move, oldest first: the ones a search can still repeat
+    std::vector<uint64_t> recent_keys() const;
+
+    // Earlier occurrences of the current position that count toward a
+    // repetition draw
+    int repetitions() const { return states_.back().repetitions; }
+    bool is_threefold() const { return repetitions() >= 2; }
+    // The fifty-move rule applies; mate on the hundredth ply still wins
+    bool is_fifty_moves() const { return pos_.halfmove_clock >= 100; }
+    bool is_checkmate() const;
+    bool is_stalemate() const;
+
+    // Checkmate and stalemate take precedence over the draw rules. Pass
+    // the number of legal moves if it is already known.
+    GameEnd end(int legal_moves = -1) const;
+
+private:
+    struct State {
+        uint64_t key;
+        int repetitions;
+        Move move;      // played from this ply; unset on the last state
+        UndoInfo undo;
+    };
+
+    Position pos_;
+    std::vector<State> states_;  // one per ply; back() is the current position
+};
+
+} // namespace chess
+
+#endif // CHESS_GAME_H
@@ -1,20 +1,285 @@
  #include <iostream>
  #include <chrono>
  #include "position.h"
+ #include "batch.h"
  #include "perft.h"
+ #include "bitboard.h"
+ #include "corpus.h"
+ #include "fen.h"
+ #include "movegen.h"
+ #include "pgn.h"
+ #include "playout.h"
+ #include "search.h"
+ #include "stats.h"
+ #include "suite.h"
+ #include "uci.h"
+ #include <fstream>
+ #include <string>
+ #include <vector>
+
+// Every position within 'depth' plies of 'pos', including 'pos' itself
+static void collect_positions(chess::Position &pos, int depth, std::vector<chess::Position> &out) {
+    out.push_back(pos);
+    if (depth == 0) return;
+    chess::MoveList moves;
+    chess::generate_legal_moves(pos, moves);
+    chess::UndoInfo undo;
+    for (chess::Move m : moves) {
+        chess::make_move(pos, m, undo);
+        collect_positions(pos, depth - 1, out);
+        chess::unmake_move(pos, m, undo);
+    }
+}
+
+// The positions of a FEN or EPD file and everything 'plies' below them
+static bool load_suite_positions(const char *path, int plies,
+    std::vector<chess::Position> &positions) {
+    std::ifstream in(path);
+    if (!in) {
+        std::cout << "Cannot open " << path << "\n";
+        return false;
+    }
+    std::string line;
+    while (std::getline(in, line)) {
+        chess::EpdEntry entry;
+        chess::Position pos;
+        // Plain FEN lines have no depth fields, which is fine here
+        bool parsed = chess::parse_epd_line(line, entry) || entry.expected.empty();
+        if (!parsed || entry.fen.empty() ||
+            chess::parse_fen(entry.fen, pos) != chess::FenError::None)
+            continue;
+        collect_positions(pos, plies, positions);
+    }
+    return true;
+}
+
+static void print_usage(const char *prog) {
+    std::cout << "Usage: " << prog << " <depth> [fen] [--hash MB] [--threads N] [--split N]\n"
+              << "       " << prog << " --suite <file.epd> [--threads N] [--max-depth N]\n"
+              << "       " << prog << " --pack <in.fen|in.epd> <out.cpos>\n"
+              << "       " << prog << " --corpus <file.cpos> [--threads N] [--max-depth N]\n"
+              << "       " << prog << " --search <depth N|movetime MS> [fen]\n"
+              << "       " << prog << " --search-bench [depth]\n"
+              << "       " << prog << " --uci [commands.txt]\n"
+              << "       " << prog << " --batch-verify <file.epd> [plies]\n"
+              << "       " << prog << " --legality-verify <file.epd> [plies]\n"
+              << "       " << prog << " --pgn <file.pgn> [out.fen|out.cpos] [--threads N]\n"
+              << "       " << prog << " --playout <games> [out.fen|out.cpos] [--threads N]\n"
+              << "           [--fens file] [--max-plies N] [--sample N] [--capture-bias PCT]\n"
+              << "           [--seed S]\n"
+              << "       " << prog << " --verify\n";
+}
 
 int main(int argc, char* argv[]) {
-    if (argc != 2) {
-        std::cout << "Usage: " << argv[0] << " <depth>\n";
+    if (argc < 2) {
+        print_usage(argv[0]);
         return 1;
     }
+    if (std::string(argv[1]) == "--verify") {
+        bool ok = chess::verify_slider_tables();
+        std::cout << "Slider tables " << (ok ? "OK" : "MISMATCH") << "\n";
+        return ok ? 0 : 1;
+    }
+    if (std::string(argv[1]) == "--uci") {
+        // Commands come from stdin, or from a file to replay a session
+        if (argc > 2) {
+            std::ifstream in(argv[2]);
+            if (!in) {
+                std::cout << "Cannot open " << argv[2] << "\n";
+                return 1;
+            }
+            chess::uci_loop(in, std::cout);
+        } else {
+            chess::uci_loop(std::cin, std::cout);
+        }
+        return 0;
+    }
+    if (std::string(argv[1]) == "--batch-verify" || std::string(argv[1]) == "--legality-verify") {
+        if (argc < 3) {
+            print_usage(argv[0]);
+            return 1;
+        }
+        int plies = argc > 3 ? std::stoi(argv[3]) : 2;
+        std::vector<chess::Position> positions;
+        if (!load_suite_positions(argv[2], plies, positions)) return 1;
+        bool ok = std::string(argv[1]) == "--batch-verify"
+                      ? chess::verify_batch_kernels(positions, std::cout)
+                      : chess::verify_move_legality(positions, std::cout);
+        return ok ? 0 : 1;
+    }
+    if (std::string(argv[1]) == "--pgn") {
+        if (argc < 3) {
+            print_usage(argv[0]);
+            return 1;
+        }
+        std::string out_path;
+        int threads = 1;
+        for (int i = 3; i < argc; ++i) {
+            std::string arg = argv[i];
+            if (arg == "--threads" && i + 1 < argc) {
+                threads = std::stoi(argv[++i]);
+            } else if (out_path.empty() && arg.rfind("--", 0) != 0) {
+                out_path = arg;
+            } else {
+                print_usage(argv[0]);
+                return 1;
+            }
+        }
+        chess::PgnStats stats;
+        return chess::replay_pgn(argv[2], chess::position_format_for(out_path), out_path,
+                                 threads, std::cout, stats) ? 0 : 1;
+    }
+    if (std::string(argv[1]) == "--playout") {
+        if (argc < 3) {
+            print_usage(argv[0]);
+            return 1;
+        }
+        chess::PlayoutOptions options;
+        options.games = std::stoull(argv[2]);
+        std::string out_path;
+        std::vector<chess::Position> starts;
+        for (int i = 3; i < argc; ++i) {
+            std::string arg = argv[i];
+            if (arg == "--threads" && i + 1 < argc) {
+                options.threads = std::stoi(argv[++i]);
+            } else if (arg == "--fens" && i + 1 < argc) {
+                if (!load_suite_positions(argv[++i], 0, starts)) return 1;
+            } else if (arg == "--max-plies" && i + 1 < argc) {
+                options.max_plies = std::stoi(argv[++i]);
+            } else if (arg == "--sample" && i + 1 < argc) {
+                options.sample_every = std::stoi(argv[++i]);
+            } else if (arg == "--capture-bias" && i + 1 < argc) {
+                options.capture_bias = std::stoi(argv[++i]);
+            } else if (arg == "--seed" && i + 1 < argc) {
+                options.seed = std::stoull(argv[++i]);
+            } else if (out_path.empty() && arg.rfind("--", 0) != 0) {
+                out_path = arg;
+            } else {
+                print_usage(argv[0]);
+                return 1;
+            }
+        }
+        if (starts.empty()) {
+            starts.emplace_back();
+            chess::init_position(starts.back());
+        }
+        chess::PlayoutStats stats;
+        return chess::run_playouts(starts, options, chess::position_format_for(out_path),
+                                   out_path, std::cout, stats) ? 0 : 1;
+    }
+    if (std::string(argv[1]) == "--search-bench") {
+        chess::run_search_bench(argc > 2 ? std::stoi(argv[2]) : 6, std::cout);
+        return 0;
+    }
+    if (std::string(argv[1]) == "--search") {
+        if (argc < 4 || argc > 5 ||
+            (std::string(argv[2]) != "depth" && std::string(argv[2]) != "movetime")) {
+            print_usage(argv[0]);
+            return 1;
+        }
+        chess::SearchLimits limits;
+        if (std::string(argv[2]) == "depth") limits.depth = std::stoi(argv[3]);
+        else limits.movetime_ms = std::stoll(argv[3]);
+        chess::Position pos;
+        chess::init_position(pos);
+        if (argc == 5) {
+            chess::FenError err = chess::parse_fen(argv[4], pos);
+            if (err != chess::FenError::None) {
+                std::cout << "Invalid FEN (" << chess::fen_error_string(err) << "): " << argv[4] << "\n";
+                return 1;
+            }
+        }
+        chess::Search search;
+        chess::SearchResult result = search.run(pos, limits, [](const chess::SearchResult &r) {
+            std::cout << "info depth " << r.depth << " seldepth " << r.seldepth << " score "
+                      << chess::score_to_string(r.score) << " nodes " << r.nodes << " nps "
+                      << uint64_t(r.seconds > 0 ? r.nodes / r.seconds : 0) << " time "
+                      << int64_t(r.seconds * 1000) << " pv";
+            for (chess::Move m : r.pv) std::cout << " " << chess::move_to_uci(m);
+            std::cout << std::endl;
+        });
+        std::cout << "bestmove " << chess::move_to_uci(result.best) << "\n";
+        return 0;
+    }
+    if (std::string(argv[1]) == "--pack") {
+        if (argc != 4) {
+            print_usage(argv[0]);
+            return 1;
+        }
+        std::ifstream in(argv[2]);
+        if (!in) {
+            std::cout << "Cannot open " << argv[2] << "\n";
+            return 1;
+        }
+        return chess::convert_to_corpus(in, argv[3], std::cout) ? 0 : 1;
+    }
+    if (std::string(argv[1]) == "--suite" || std::string(argv[1]) == "--corpus") {
+        if (argc < 3) {
+            print_usage(argv[0]);
+            return 1;
+        }
+        int threads = 1;
+        int max_depth = 0;
+        for (int i = 3; i < argc; ++i) {
+            std::string arg = argv[i];
+            if (arg == "--threads" && i + 1 < argc) {
+                threads = std::stoi(argv[++i]);
+            } else if (arg == "--max-depth" && i + 1 < argc) {
+                max_depth = std::stoi(argv[++i]);
+            } else {
+                print_usage(argv[0]);
+                return 1;
+            }
+        }
+        if (std::string(argv[1]) == "--corpus") {
+            chess::CorpusReader corpus;
+            if (!corpus.open(argv[2])) {
+                std::cout << "Cannot open corpus: " << argv[2] << "\n";
+                return 1;
+            }
+            return chess::run_corpus_suite(corpus, std::cout, threads, max_depth) ? 0 : 1;
+        }
+        std::ifstream in(argv[2]);
+        if (!in) {
+            std::cout << "Cannot open suite: " << argv[2] << "\n";
+            return 1;
+        }
+        return chess::run_epd_suite(in, std::cout, threads, max_depth) ? 0 : 1;
+    }
     int depth = std::stoi(argv[1]);
+    std::string fen;
+    size_t hash_mb = 0;
+    int threads = 1;
+    int split_depth = 2;
+    for (int i = 2; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--hash" && i + 1 < argc) {
+            hash_mb = std::stoul(argv[++i]);
+        } else if (arg == "--threads" && i + 1 < argc) {
+            threads = std::stoi(argv[++i]);
+        } else if (arg == "--split" && i + 1 < argc) {
+            split_depth = std::stoi(argv[++i]);
+        } else if (fen.empty() && arg.rfind("--", 0) != 0) {
+            fen = arg;
+        } else {
+            print_usage(argv[0]);
+            return 1;
+        }
+    }
     chess::Position pos;
     chess::init_position(pos);
+    if (!fen.empty()) {
+        chess::FenError err = chess::parse_fen(fen, pos);
+        if (err != chess::FenError::None) {
+            std::cout << "Invalid FEN (" << chess::fen_error_string(err) << "): " << fen << "\n";
+            return 1;
+        }
+    }
     auto start = std::chrono::high_resolution_clock::now();
-    uint64_t nodes = chess::perft(pos, depth);
+    uint64_t nodes = chess::perft_parallel(pos, depth, threads, split_depth, hash_mb);
     auto end = std::chrono::high_resolution_clock::now();
     double secs = std::chrono::duration<double>(end - start).count();
     std::cout << "Perft(" << depth << ") : " << nodes << " nodes in " << secs << " seconds\n";
+    chess::stats::report(std::cout);
     return 0;
-}
\ No newline at end of file
+}
@@ -1,274 +1,589 @@
  #include "movegen.h"
  #include "bitboard.h"
+ #include "fen.h"
+ #include "stats.h"
+ #include <algorithm>
+ #include <cstring>
+ #include <ostream>
 
 namespace chess {
 
-// Determine if square 'sq' is attacked by side 'attacker'
-static bool is_square_attacked(const Position &pos, int sq, Color attacker) {
-    // Pawn attacks
-    if (attacker == WHITE) {
-        if (pawn_attacks[BLACK][sq] & pos.pieces[WP]) return true;
-    } else {
-        if (pawn_attacks[WHITE][sq] & pos.pieces[BP]) return true;
-    }
-    // Knight attacks
-    if (knight_attacks[sq] & pos.pieces[attacker == WHITE ? WN : BN]) return true;
-    // King attacks
-    if (king_attacks[sq] & pos.pieces[attacker == WHITE ? WK : BK]) return true;
+// Compile-time constants for the side to move
+template <Color Us>
+struct Side {
+    static constexpr Color Them = Us == WHITE ? BLACK : WHITE;
+    static constexpr int Push = Us == WHITE ? 8 : -8;
+    // Pawn capture directions toward the a-file and the h-file
+    static constexpr int CaptureWest = Us == WHITE ? 7 : -9;
+    static constexpr int CaptureEast = Us == WHITE ? 9 : -7;
+    // Promotion rank, and the rank a single push from the start rank lands on
+    static constexpr Bitboard LastRank = rank_bb(Us == WHITE ? 7 : 0);
+    static constexpr Bitboard ThirdRank = rank_bb(Us == WHITE ? 2 : 5);
+    // Index of this side's first castling right in castle_rights
+    static constexpr int FirstRight = Us == WHITE ? 0 : 2;
+    static constexpr Piece Pawn = make_piece(Us, PAWN);
+    static constexpr Piece Knight = make_piece(Us, KNIGHT);
+    static constexpr Piece Bishop = make_piece(Us, BISHOP);
+    static constexpr Piece Rook = make_piece(Us, ROOK);
+    static constexpr Piece Queen = make_piece(Us, QUEEN);
+    static constexpr Piece King = make_piece(Us, KING);
+};
+
+// Legality information computed once per position before generation
+struct LegalMasks {
+    int king_sq;
+    Bitboard checkers;
+    Bitboard pinned;
+    // Destination squares that resolve a single check; all squares when not in check
+    Bitboard check_mask;
+};
+
+// Attack set of a knight, bishop, rook or queen on 'sq'
+template <PieceType Pt>
+static inline Bitboard piece_attacks(int sq, Bitboard occ) {
+    if constexpr (Pt == KNIGHT) return knight_attacks[sq];
+    else if constexpr (Pt == BISHOP) return bishop_attacks(sq, occ);
+    else if constexpr (Pt == ROOK) return rook_attacks(sq, occ);
+    else return queen_attacks(sq, occ);
+}
+
+// Diagonal and orthogonal sliders of side 'C'
+template <Color C>
+static inline Bitboard diagonal_sliders(const Position &pos) {
+    return pos.pieces[Side<C>::Bishop] | pos.pieces[Side<C>::Queen];
+}
+
+template <Color C>
+static inline Bitboard orthogonal_sliders(const Position &pos) {
+    return pos.pieces[Side<C>::Rook] | pos.pieces[Side<C>::Queen];
+}
+
+// Determine if square 'sq' is attacked by side 'Attacker' under occupancy 'occ'
+template <Color Attacker>
+static inline bool is_square_attacked(const Position &pos, int sq, Bitboard occ) {
+    using A = Side<Attacker>;
+    // Pawn, knight and king attacks
+    if (pawn_attacks[A::Them][sq] & pos.pieces[A::Pawn]) return true;
+    if (knight_attacks[sq] & pos.pieces[A::Knight]) return true;
+    if (king_attacks[sq] & pos.pieces[A::King]) return true;
     // Sliding attacks
-    Bitboard occ = pos.occupancies[2];
-    static const int bishop_dirs[4] = {9, 7, -9, -7};
-    Bitboard diag_att = sliding_attacks(sq, occ, bishop_dirs, 4);
-    Bitboard diag_mask = pos.pieces[attacker == WHITE ? WB : BB] |
-                         pos.pieces[attacker == WHITE ? WQ : BQ];
-    if (diag_att & diag_mask) return true;
-    static const int rook_dirs[4] = {8, -8, 1, -1};
-    Bitboard orth_att = sliding_attacks(sq, occ, rook_dirs, 4);
-    Bitboard orth_mask = pos.pieces[attacker == WHITE ? WR : BR] |
-                         pos.pieces[attacker == WHITE ? WQ : BQ];
-    if (orth_att & orth_mask) return true;
+    if (bishop_attacks(sq, occ) & diagonal_sliders<Attacker>(pos)) return true;
+    if (rook_attacks(sq, occ) & orthogonal_sliders<Attacker>(pos)) return true;
     return false;
 }
 
-static void generate_pawn_moves(const Position &pos, Color side, Color opp,
-    Bitboard own_occ, Bitboard opp_occ, Bitboard all_occ,
-    std::vector<Move> &moves) {
-    Bitboard pawns = pos.pieces[side == WHITE ? WP : BP];
-    while (pawns) {
-        Bitboard b = pop_lsb(pawns);
-        int from = get_lsb_index(b);
-        if (side == WHITE) {
-            int to = from + 8;
-            if (to < 64 && !(all_occ & (1ULL << to))) {
-                int r = from / 8;
-                if (r == 6) {
-                    moves.push_back({from, to, WQ, false, false, false});
-                    moves.push_back({from, to, WR, false, false, false});
-                    moves.push_back({from, to, WB, false, false, false});
-                    moves.push_back({from, to, WN, false, false, false});
-                } else {
-                    moves.push_back({from, to, NO_PIECE, false, false, false});
-                    if (r == 1) {
-                        int to2 = from + 16;
-                        if (!(all_occ & (1ULL << to2)))
-                            moves.push_back({from, to2, NO_PIECE, false, false, false});
-                    }
-                }
-            }
-            Bitboard attacks_bb = pawn_attacks[WHITE][from] & opp_occ;
-            while (attacks_bb) {
-                Bitboard l = pop_lsb(attacks_bb);
-                int to = get_lsb_index(l);
-                int r = from / 8;
-                if (r == 6) {
-                    moves.push_back({from, to, WQ, true, false, false});
-                    moves.push_back({from, to, WR, true, false, false});
-                    moves.push_back({from, to, WB, true, false, false});
-                    moves.push_back({from, to, WN, true, false, false});
-                } else {
-                    moves.push_back({from, to, NO_PIECE, true, false, false});
-                }
-            }
-            if (pos.en_passant >= 0) {
-                Bitboard epb = (1ULL << pos.en_passant);
-                if (pawn_attacks[WHITE][from] & epb)
-                    moves.push_back({from, pos.en_passant, NO_PIECE, true, true, false});
-            }
-        } else {
-            int to = from - 8;
-            if (to >= 0 && !(all_occ & (1ULL << to))) {
-                int r = from / 8;
-                if (r == 1) {
-                    moves.push_back({from, to, BQ, false, false, false});
-                    moves.push_back({from, to, BR, false, false, false});
-                    moves.push_back({from, to, BB, false, false, false});
-                    moves.push_back({from, to, BN, false, false, false});
-                } else {
-                    moves.push_back({from, to, NO_PIECE, false, false, false});
-                    if (r == 6) {
-                        int to2 = from - 16;
-                        if (!(all_occ & (1ULL << to2)))
-                            moves.push_back({from, to2, NO_PIECE, false, false, false});
-                    }
-                }
-            }
-            Bitboard attacks_bb = pawn_attacks[BLACK][from] & opp_occ;
-            while (attacks_bb) {
-                Bitboard l = pop_lsb(attacks_bb);
-                int to = get_lsb_index(l);
-                int r = from / 8;
-                if (r == 1) {
-                    moves.push_back({from, to, BQ, true, false, false});
-                    moves.push_back({from, to, BR, true, false, false});
-                    moves.push_back({from, to, BB, true, false, false});
-                    moves.push_back({from, to, BN, true, false, false});
-                } else {
-                    moves.push_back({from, to, NO_PIECE, true, false, false});
-                }
-            }
-            if (pos.en_passant >= 0) {
-                Bitboard epb = (1ULL << pos.en_passant);
-                if (pawn_attacks[BLACK][from] & epb)
-                    moves.push_back({from, pos.en_passant, NO_PIECE, true, true, false});
-            }
-        }
+// Gather the cached checkers and pins and derive the check evasion mask
+template <Color Us>
+static inline LegalMasks compute_legal_masks(const Position &pos) {
+    STAT_TIMER(TimeLegalMasks);
+    LegalMasks lm;
+    lm.king_sq = get_lsb_index(pos.pieces[Side<Us>::King]);
+    lm.checkers = pos.checkers;
+    lm.pinned = pos.pinned;
+    if (!lm.checkers) {
+        lm.check_mask = ~0ULL;
+    } else {
+        int c = get_lsb_index(lm.checkers);
+        lm.check_mask = between_bb[lm.king_sq][c] | lm.checkers;
     }
+    return lm;
 }
 
-static void generate_knight_moves(const Position &pos, Color side,
-    Bitboard own_occ, Bitboard opp_occ,
-    std::vector<Move> &moves) {
-    Bitboard knights = pos.pieces[side == WHITE ? WN : BN];
-    while (knights) {
-        Bitboard b = pop_lsb(knights);
-        int from = get_lsb_index(b);
-        Bitboard attacks_bb = knight_attacks[from] & ~own_occ;
-        while (attacks_bb) {
-            Bitboard l = pop_lsb(attacks_bb);
-            int to = get_lsb_index(l);
-            bool cap = bool(opp_occ & l);
-            moves.push_back({from, to, NO_PIECE, cap, false, false});
-        }
+// Squares a piece on 'from' may move to without exposing its own king
+static inline Bitboard legal_targets(const LegalMasks &lm, int from) {
+    return (lm.pinned & (1ULL << from)) ? lm.check_mask & line_bb[lm.king_sq][from]
+                                        : lm.check_mask;
+}
+
+// En passant removes two pawns from one rank, so it is checked by playing it out
+template <Color Us>
+static bool en_passant_is_legal(const Position &pos, const LegalMasks &lm, int from, int to) {
+    constexpr Color Them = Side<Us>::Them;
+    int cap_sq = to - Side<Us>::Push;
+    if (!((lm.check_mask & (1ULL << to)) || (lm.checkers & (1ULL << cap_sq))))
+        return false;
+    Bitboard occ = (pos.occupied() ^ (1ULL << from) ^ (1ULL << cap_sq)) | (1ULL << to);
+    return !(bishop_attacks(lm.king_sq, occ) & diagonal_sliders<Them>(pos)) &&
+           !(rook_attacks(lm.king_sq, occ) & orthogonal_sliders<Them>(pos));
+}
+
+// Add all four promotions; 'flags' is QUIET or CAPTURE
+static inline void add_promotions(MoveList &moves, int from, int to, int flags) {
+    moves.push_back(Move(from, to, flags | PROMO_QUEEN));
+    moves.push_back(Move(from, to, flags | PROMO_ROOK));
+    moves.push_back(Move(from, to, flags | PROMO_BISHOP));
+    moves.push_back(Move(from, to, flags | PROMO_KNIGHT));
+}
+
+// Add one move per square in 'targets', each coming from 'to - Delta'
+template <int Delta>
+static inline void add_pawn_moves(MoveList &moves, Bitboard targets, int flags) {
+    while (targets) {
+        int to = get_lsb_index(pop_lsb(targets));
+        moves.push_back(Move(to - Delta, to, flags));
     }
 }
 
-static void generate_bishop_moves(const Position &pos, Color side,
-    Bitboard own_occ, Bitboard opp_occ, Bitboard all_occ,
-    std::vector<Move> &moves) {
-    static const int bishop_dirs[4] = {9, 7, -9, -7};
-    Bitboard bishops = pos.pieces[side == WHITE ? WB : BB];
-    while (bishops) {
-        Bitboard b = pop_lsb(bishops);
-        int from = get_lsb_index(b);
-        Bitboard att = sliding_attacks(from, all_occ, bishop_dirs, 4) & ~own_occ;
-        while (att) {
-            Bitboard l = pop_lsb(att);
-            int to = get_lsb_index(l);
-            bool cap = bool(opp_occ & l);
-            moves.push_back({from, to, NO_PIECE, cap, false, false});
-        }
+template <int Delta>
+static inline void add_pawn_promotions(MoveList &moves, Bitboard targets, int flags) {
+    while (targets) {
+        int to = get_lsb_index(pop_lsb(targets));
+        add_promotions(moves, to - Delta, to, flags);
     }
 }
 
-static void generate_rook_moves(const Position &pos, Color side,
-    Bitboard own_occ, Bitboard opp_occ, Bitboard all_occ,
-    std::vector<Move> &moves) {
-    static const int rook_dirs[4] = {8, -8, 1, -1};
-    Bitboard rooks = pos.pieces[side == WHITE ? WR : BR];
-    while (rooks) {
-        Bitboard b = pop_lsb(rooks);
-        int from = get_lsb_index(b);
-        Bitboard att = sliding_attacks(from, all_occ, rook_dirs, 4) & ~own_occ;
-        while (att) {
-            Bitboard l = pop_lsb(att);
-            int to = get_lsb_index(l);
-            bool cap = bool(opp_occ & l);
-            moves.push_back({from, to, NO_PIECE, cap, false, false});
-        }
+// Target sets of a group of pawns, computed with whole-board shifts
+template <Color Us>
+struct PawnTargets {
+    Bitboard push, double_push, west, east;
+
+    PawnTargets(Bitboard pawns, Bitboard opp_occ, Bitboard all_occ, Bitboard allowed) {
+        using S = Side<Us>;
+        Bitboard empty = ~all_occ;
+        Bitboard single = shift<S::Push>(pawns) & empty;
+        double_push = shift<S::Push>(single & S::ThirdRank) & empty & allowed;
+        push = single & allowed;
+        west = shift<S::CaptureWest>(pawns) & opp_occ & allowed;
+        east = shift<S::CaptureEast>(pawns) & opp_occ & allowed;
+    }
+};
+
+// Promotions, quiet or not, count as captures for GenType purposes
+template <Color Us, GenType Type>
+static void add_pawn_targets(const PawnTargets<Us> &t, MoveList &moves) {
+    using S = Side<Us>;
+    constexpr Bitboard Last = S::LastRank;
+    if constexpr (Type != GEN_QUIETS) {
+        add_pawn_promotions<S::Push>(moves, t.push & Last, QUIET);
+        add_pawn_promotions<S::CaptureWest>(moves, t.west & Last, CAPTURE);
+        add_pawn_promotions<S::CaptureEast>(moves, t.east & Last, CAPTURE);
     }
+    if constexpr (Type != GEN_CAPTURES) {
+        add_pawn_moves<S::Push>(moves, t.push & ~Last, QUIET);
+        add_pawn_moves<2 * S::Push>(moves, t.double_push, DOUBLE_PUSH);
+    }
+    if constexpr (Type != GEN_QUIETS) {
+        add_pawn_moves<S::CaptureWest>(moves, t.west & ~Last, CAPTURE);
+        add_pawn_moves<S::CaptureEast>(moves, t.east & ~Last, CAPTURE);
+    }
+}
+
+template <Color Us>
+static inline int count_pawn_targets(const PawnTargets<Us> &t) {
+    constexpr Bitboard Last = Side<Us>::LastRank;
+    return popcount(t.push & ~Last) + popcount(t.double_push) +
+           popcount(t.west & ~Last) + popcount(t.east & ~Last) +
+           4 * popcount((t.push | t.west | t.east) & Last);
 }
 
-static void generate_queen_moves(const Position &pos, Color side,
-    Bitboard own_occ, Bitboard opp_occ, Bitboard all_occ,
-    std::vector<Move> &moves) {
-    static const int bishop_dirs[4] = {9, 7, -9, -7};
-    static const int rook_dirs[4] = {8, -8, 1, -1};
-    Bitboard queens = pos.pieces[side == WHITE ? WQ : BQ];
-    while (queens) {
-        Bitboard b = pop_lsb(queens);
+// En passant is tested per capturing pawn, pinned or not
+template <Color Us>
+static inline Bitboard en_passant_capturers(const Position &pos) {
+    if (pos.en_passant < 0) return 0;
+    return pawn_attacks[Side<Us>::Them][pos.en_passant] & pos.pieces[Side<Us>::Pawn];
+}
+
+template <Color Us, GenType Type>
+static void generate_pawn_moves(const Position &pos, Bitboard opp_occ, Bitboard all_occ,
+    const LegalMasks &lm, MoveList &moves) {
+    STAT_TIMER(TimePawnMoves);
+    Bitboard pawns = pos.pieces[Side<Us>::Pawn];
+    // Unpinned pawns move as one set
+    add_pawn_targets<Us, Type>(
+        PawnTargets<Us>(pawns & ~lm.pinned, opp_occ, all_occ, lm.check_mask), moves);
+    // Pinned pawns are rare; each is limited to its own pin line
+    Bitboard pinned = pawns & lm.pinned;
+    while (pinned) {
+        Bitboard b = pop_lsb(pinned);
         int from = get_lsb_index(b);
-        Bitboard att = (sliding_attacks(from, all_occ, bishop_dirs, 4) |
-                        sliding_attacks(from, all_occ, rook_dirs, 4)) & ~own_occ;
+        add_pawn_targets<Us, Type>(PawnTargets<Us>(b, opp_occ, all_occ, legal_targets(lm, from)),
+                                   moves);
+    }
+    if constexpr (Type == GEN_QUIETS) return;
+    Bitboard ep = en_passant_capturers<Us>(pos);
+    while (ep) {
+        int from = get_lsb_index(pop_lsb(ep));
+        if (en_passant_is_legal<Us>(pos, lm, from, pos.en_passant))
+            moves.push_back(Move(from, pos.en_passant, EN_PASSANT));
+        else
+            STAT_INC(EnPassantRejected);
+    }
+}
+
+// Knight, bishop, rook and queen moves to squares in 'targets'
+template <Color Us, PieceType Pt>
+static void generate_piece_moves(const Position &pos, Bitboard targets, Bitboard opp_occ,
+    Bitboard all_occ, const LegalMasks &lm, MoveList &moves) {
+    STAT_TIMER(TimePieceMoves);
+    Bitboard pieces = pos.pieces[make_piece(Us, Pt)];
+    // A pinned knight can never move
+    if constexpr (Pt == KNIGHT) pieces &= ~lm.pinned;
+    while (pieces) {
+        int from = get_lsb_index(pop_lsb(pieces));
+        Bitboard att = piece_attacks<Pt>(from, all_occ) & targets & legal_targets(lm, from);
         while (att) {
             Bitboard l = pop_lsb(att);
             int to = get_lsb_index(l);
-            bool cap = bool(opp_occ & l);
-            moves.push_back({from, to, NO_PIECE, cap, false, false});
+            moves.push_back(Move(from, to, (opp_occ & l) ? CAPTURE : QUIET));
         }
     }
 }
 
-static void generate_king_moves(const Position &pos, Color side,
-    Bitboard own_occ, Bitboard opp_occ,
-    std::vector<Move> &moves) {
-    Bitboard king_bb = pos.pieces[side == WHITE ? WK : BK];
-    int from = get_lsb_index(king_bb);
-    Bitboard att = king_attacks[from] & ~own_occ;
+template <Color Us>
+static void generate_king_moves(const Position &pos, Bitboard targets, Bitboard opp_occ,
+    Bitboard all_occ, const LegalMasks &lm, MoveList &moves) {
+    STAT_TIMER(TimeKingMoves);
+    int from = lm.king_sq;
+    // Remove the king so squares behind it along a checking ray stay attacked
+    Bitboard occ = all_occ ^ (1ULL << from);
+    Bitboard att = king_attacks[from] & targets;
     while (att) {
         Bitboard l = pop_lsb(att);
         int to = get_lsb_index(l);
-        bool cap = bool(opp_occ & l);
-        moves.push_back({from, to, NO_PIECE, cap, false, false});
+        STAT_INC(AttackChecksLegality);
+        if (is_square_attacked<Side<Us>::Them>(pos, to, occ)) {
+            STAT_INC(KingTargetsRejected);
+            continue;
+        }
+        moves.push_back(Move(from, to, (opp_occ & l) ? CAPTURE : QUIET));
     }
 }
 
-static void generate_castling_moves(const Position &pos, Color side,
-    Bitboard all_occ, std::vector<Move> &moves) {
-    if (side == WHITE) {
-        // King side
-        if (pos.castle_rights[0] &&
-            !(all_occ & ((1ULL<<5)|(1ULL<<6))) &&
-            !is_square_attacked(pos, 4, BLACK) &&
-            !is_square_attacked(pos, 5, BLACK) &&
-            !is_square_attacked(pos, 6, BLACK)) {
-            moves.push_back({4, 6, NO_PIECE, false, false, true});
+// Squares involved in each castling right, indexed like castle_rights
+struct CastlingPath {
+    int king_from;
+    int king_to;
+    Bitboard must_be_empty;
+    int crossed;  // square the king passes over
+};
+
+static constexpr CastlingPath castling_paths[4] = {
+    {4, 6, (1ULL<<5)|(1ULL<<6), 5},
+    {4, 2, (1ULL<<1)|(1ULL<<2)|(1ULL<<3), 3},
+    {60, 62, (1ULL<<61)|(1ULL<<62), 61},
+    {60, 58, (1ULL<<57)|(1ULL<<58)|(1ULL<<59), 59},
+};
+
+// Only valid when not in check, so the king square itself is safe
+template <Color Us, int Right>
+static inline bool can_castle(const Position &pos, Bitboard all_occ) {
+    constexpr CastlingPath c = castling_paths[Right];
+    constexpr Color Them = Side<Us>::Them;
+    if (!pos.has_castle_right(Right) || (all_occ & c.must_be_empty)) return false;
+    STAT_INC(AttackChecksCastling);
+    if (!is_square_attacked<Them>(pos, c.crossed, all_occ)) {
+        STAT_INC(AttackChecksCastling);
+        if (!is_square_attacked<Them>(pos, c.king_to, all_occ)) return true;
+    }
+    STAT_INC(CastlesRejected);
+    return false;
+}
+
+template <Color Us>
+static void generate_castling_moves(const Position &pos, Bitboard all_occ, MoveList &moves) {
+    STAT_TIMER(TimeCastling);
+    constexpr int K = Side<Us>::FirstRight, Q = K + 1;
+    if (can_castle<Us, K>(pos, all_occ))
+        moves.push_back(Move(castling_paths[K].king_from, castling_paths[K].king_to, CASTLING));
+    if (can_castle<Us, Q>(pos, all_occ))
+        moves.push_back(Move(castling_paths[Q].king_from, castling_paths[Q].king_to, CASTLING));
+}
+
+template <Color Us, GenType Type>
+void generate_legal_moves(const Position &pos, MoveList &moves) {
+    STAT_INC(MovegenCalls);
+    int first = moves.size();
+    Bitboard own_occ = pos.occupancies[Us];
+    Bitboard opp_occ = pos.occupancies[Side<Us>::Them];
+    Bitboard all_occ = pos.occupied();
+    Bitboard targets = Type == GEN_CAPTURES ? opp_occ : Type == GEN_QUIETS ? ~all_occ : ~own_occ;
+    LegalMasks lm = compute_legal_masks<Us>(pos);
+    generate_king_moves<Us>(pos, targets, opp_occ, all_occ, lm, moves);
+    // In double check only the king can move
+    if (lm.checkers & (lm.checkers - 1)) {
+        STAT_ADD(MovesGenerated, moves.size() - first);
+        return;
+    }
+    generate_pawn_moves<Us, Type>(pos, opp_occ, all_occ, lm, moves);
+    generate_piece_moves<Us, KNIGHT>(pos, targets, opp_occ, all_occ, lm, moves);
+    generate_piece_moves<Us, BISHOP>(pos, targets, opp_occ, all_occ, lm, moves);
+    generate_piece_moves<Us, ROOK>(pos, targets, opp_occ, all_occ, lm, moves);
+    generate_piece_moves<Us, QUEEN>(pos, targets, opp_occ, all_occ, lm, moves);
+    if (Type != GEN_CAPTURES && !lm.checkers) generate_castling_moves<Us>(pos, all_occ, moves);
+    STAT_ADD(MovesGenerated, moves.size() - first);
+}
+
+template void generate_legal_moves<WHITE, GEN_ALL>(const Position &, MoveList &);
+template void generate_legal_moves<BLACK, GEN_ALL>(const Position &, MoveList &);
+template void generate_legal_moves<WHITE, GEN_CAPTURES>(const Position &, MoveList &);
+template void generate_legal_moves<BLACK, GEN_CAPTURES>(const Position &, MoveList &);
+template void generate_legal_moves<WHITE, GEN_QUIETS>(const Position &, MoveList &);
+template void generate_legal_moves<BLACK, GEN_QUIETS>(const Position &, MoveList &);
+
+template <Color Us>
+static bool is_pseudo_legal(const Position &pos, Move m) {
+    using S = Side<Us>;
+    int from = m.from(), to = m.to();
+    Piece piece = pos.board[from];
+    if (piece == NO_PIECE || piece / 6 != Us) return false;
+    Bitboard to_bb = 1ULL << to;
+    if (pos.occupancies[Us] & to_bb) return false;
+    int flags = m.flags();
+    if (flags == 3 || flags == 6 || flags == 7) return false;
+
+    if (m.is_castling()) {
+        if (piece != S::King) return false;
+        for (int right = S::FirstRight; right < S::FirstRight + 2; ++right) {
+            const CastlingPath &c = castling_paths[right];
+            if (from == c.king_from && to == c.king_to)
+                return pos.has_castle_right(right) && !(pos.occupied() & c.must_be_empty);
         }
-        // Queen side
-        if (pos.castle_rights[1] &&
-            !(all_occ & ((1ULL<<1)|(1ULL<<2)|(1ULL<<3))) &&
-            !is_square_attacked(pos, 4, BLACK) &&
-            !is_square_attacked(pos, 3, BLACK) &&
-            !is_square_attacked(pos, 2, BLACK)) {
-            moves.push_back({4, 2, NO_PIECE, false, false, true});
+        return false;
+    }
+    if (m.is_en_passant())
+        return piece == S::Pawn && to == pos.en_passant && (pawn_attacks[Us][from] & to_bb);
+    // The capture flag must agree with the board
+    if (m.is_capture() != bool(pos.occupancies[S::Them] & to_bb)) return false;
+
+    if (piece == S::Pawn) {
+        if (m.is_promotion() != bool(to_bb & S::LastRank)) return false;
+        if (m.is_capture()) return pawn_attacks[Us][from] & to_bb;
+        if (m.is_double_push())
+            return from + 2 * S::Push == to && (shift<S::Push>(1ULL << from) & S::ThirdRank) &&
+                   pos.board[from + S::Push] == NO_PIECE;
+        return from + S::Push == to;
+    }
+    if (m.is_promotion() || m.is_double_push()) return false;
+    switch (piece % 6) {
+        case KNIGHT: return knight_attacks[from] & to_bb;
+        case BISHOP: return bishop_attacks(from, pos.occupied()) & to_bb;
+        case ROOK: return rook_attacks(from, pos.occupied()) & to_bb;
+        case QUEEN: return queen_attacks(from, pos.occupied()) & to_bb;
+        default: return king_attacks[from] & to_bb;
+    }
+}
+
+// Whether a pseudo-legal move keeps the king safe, from the cached
+// checkers and pins; only king moves and castling probe attacks
+template <Color Us>
+static bool is_legal(const Position &pos, Move m) {
+    constexpr Color Them = Side<Us>::Them;
+    LegalMasks lm = compute_legal_masks<Us>(pos);
+    int from = m.from(), to = m.to();
+    if (from == lm.king_sq) {
+        if (m.is_castling()) {
+            int right = Side<Us>::FirstRight + (to < from);
+            return !lm.checkers && !is_square_attacked<Them>(pos, castling_paths[right].crossed,
+                                                             pos.occupied()) &&
+                   !is_square_attacked<Them>(pos, to, pos.occupied());
         }
-    } else {
-        // King side
-        if (pos.castle_rights[2] &&
-            !(all_occ & ((1ULL<<61)|(1ULL<<62))) &&
-            !is_square_attacked(pos, 60, WHITE) &&
-            !is_square_attacked(pos, 61, WHITE) &&
-            !is_square_attacked(pos, 62, WHITE)) {
-            moves.push_back({60, 62, NO_PIECE, false, false, true});
+        return !is_square_attacked<Them>(pos, to, pos.occupied() ^ (1ULL << from));
+    }
+    if (lm.checkers & (lm.checkers - 1)) return false;
+    if (m.is_en_passant()) return en_passant_is_legal<Us>(pos, lm, from, to);
+    return legal_targets(lm, from) & (1ULL << to);
+}
+
+bool is_pseudo_legal(const Position &pos, Move m) {
+    return pos.side_to_move == WHITE ? is_pseudo_legal<WHITE>(pos, m)
+                                     : is_pseudo_legal<BLACK>(pos, m);
+}
+
+bool is_legal(const Position &pos, Move m) {
+    if (pos.side_to_move == WHITE) return is_pseudo_legal<WHITE>(pos, m) && is_legal<WHITE>(pos, m);
+    return is_pseudo_legal<BLACK>(pos, m) && is_legal<BLACK>(pos, m);
+}
+
+bool is_square_attacked(const Position &pos, int sq, Color by) {
+    return by == WHITE ? is_square_attacked<WHITE>(pos, sq, pos.occupied())
+                       : is_square_attacked<BLACK>(pos, sq, pos.occupied());
+}
+
+bool in_check(const Position &pos) {
+    return pos.checkers != 0;
+}
+
+std::string move_to_uci(Move m) {
+    if (m == Move(0, 0)) return "0000";
+    std::string s;
+    s += char('a' + m.from() % 8);
+    s += char('1' + m.from() / 8);
+    s += char('a' + m.to() % 8);
+    s += char('1' + m.to() / 8);
+    if (m.is_promotion()) s += "nbrq"[m.promotion_type() - KNIGHT];
+    return s;
+}
+
+static inline int parse_square(const char *s) {
+    if (s[0] < 'a' || s[0] > 'h' || s[1] < '1' || s[1] > '8') return -1;
+    return (s[1] - '1') * 8 + (s[0] - 'a');
+}
+
+Move move_from_uci(const Position &pos, const std::string &text) {
+    if (text.size() != 4 && text.size() != 5) return Move(0, 0);
+    int from = parse_square(text.c_str()), to = parse_square(text.c_str() + 2);
+    if (from < 0 || to < 0) return Move(0, 0);
+    // The flags follow from the board; is_legal rejects anything else
+    Piece piece = pos.board[from];
+    int flags = pos.board[to] != NO_PIECE ? CAPTURE : QUIET;
+    if (piece % 6 == KING && piece != NO_PIECE && (from == 4 || from == 60) &&
+        (to == from + 2 || to == from - 2)) {
+        flags = CASTLING;
+    } else if (piece % 6 == PAWN && piece != NO_PIECE) {
+        if (to == pos.en_passant) flags = EN_PASSANT;
+        else if (to == from + 16 || to == from - 16) flags = DOUBLE_PUSH;
+    }
+    if (text.size() == 5) {
+        const char *promo = "nbrq";
+        const char *p = text[4] ? std::strchr(promo, text[4]) : nullptr;
+        if (!p) return Move(0, 0);
+        flags = (flags & CAPTURE) | PROMOTION | int(p - promo);
+    }
+    Move m(from, to, flags);
+    return is_legal(pos, m) ? m : Move(0, 0);
+}
+
+bool verify_move_legality(const std::vector<Position> &positions, std::ostream &out) {
+    size_t mismatches = 0;
+    std::vector<uint8_t> legal(1 << 16);
+    for (const Position &pos : positions) {
+        MoveList moves;
+        generate_legal_moves(pos, moves);
+        std::fill(legal.begin(), legal.end(), 0);
+        for (Move m : moves) legal[m.data] = 1;
+        bool ok = true;
+        for (uint32_t data = 0; data < (1 << 16) && ok; ++data) {
+            Move m;
+            m.data = uint16_t(data);
+            ok = is_legal(pos, m) == legal[data] && (!legal[data] || is_pseudo_legal(pos, m));
         }
-        // Queen side
-        if (pos.castle_rights[3] &&
-            !(all_occ & ((1ULL<<57)|(1ULL<<58)|(1ULL<<59))) &&
-            !is_square_attacked(pos, 60, WHITE) &&
-            !is_square_attacked(pos, 59, WHITE) &&
-            !is_square_attacked(pos, 58, WHITE)) {
-            moves.push_back({60, 58, NO_PIECE, false, false, true});
+        for (Move m : moves) ok = ok && move_from_uci(pos, move_to_uci(m)) == m;
+        if (ok) continue;
+        if (++mismatches <= 5) {
+            char fen[FEN_BUFFER_SIZE];
+            write_fen(pos, fen, sizeof(fen));
+            out << "Legality mismatch: " << fen << "\n";
         }
     }
+    out << "Legality checks " << (mismatches ? "FAILED" : "agree") << " ("
+        << positions.size() - mismatches << "/" << positions.size() << " positions)\n";
+    return mismatches == 0;
 }
 
-void generate_legal_moves(const Position &pos, std::vector<Move> &moves) {
-    init_attack_tables();
+void generate_legal_moves(const Position &pos, MoveList &moves) {
     moves.clear();
-    std::vector<Move> pseudo;
-    pseudo.reserve(256);
-    Color side = pos.side_to_move;
-    Color opp = side == WHITE ? BLACK : WHITE;
-    Bitboard own_occ = pos.occupancies[side];
-    Bitboard opp_occ = pos.occupancies[opp];
-    Bitboard all_occ = pos.occupancies[2];
-    // Generate pseudolegal moves
-    generate_pawn_moves(pos, side, opp, own_occ, opp_occ, all_occ, pseudo);
-    generate_knight_moves(pos, side, own_occ, opp_occ, pseudo);
-    generate_bishop_moves(pos, side, own_occ, opp_occ, all_occ, pseudo);
-    generate_rook_moves(pos, side, own_occ, opp_occ, all_occ, pseudo);
-    generate_queen_moves(pos, side, own_occ, opp_occ, all_occ, pseudo);
-    generate_king_moves(pos, side, own_occ, opp_occ, pseudo);
-    generate_castling_moves(pos, side, all_occ, pseudo);
-    // Filter legal moves
-    moves.reserve(pseudo.size());
-    for (const Move &m : pseudo) {
-        Position new_pos = pos;
-        make_move(new_pos, m);
-        int king_sq = get_lsb_index(new_pos.pieces[side == WHITE ? WK : BK]);
-        if (!is_square_attacked(new_pos, king_sq, new_pos.side_to_move)) {
-            moves.push_back(m);
-        }
+    if (pos.side_to_move == WHITE) generate_legal_moves<WHITE>(pos, moves);
+    else generate_legal_moves<BLACK>(pos, moves);
+}
+
+void generate_legal_moves(const Position &pos, MoveList &moves, GenType type) {
+    moves.clear();
+    bool white = pos.side_to_move == WHITE;
+    switch (type) {
+        case GEN_CAPTURES:
+            if (white) generate_legal_moves<WHITE, GEN_CAPTURES>(pos, moves);
+            else generate_legal_moves<BLACK, GEN_CAPTURES>(pos, moves);
+            break;
+        case GEN_QUIETS:
+            if (white) generate_legal_moves<WHITE, GEN_QUIETS>(pos, moves);
+            else generate_legal_moves<BLACK, GEN_QUIETS>(pos, moves);
+            break;
+        default:
+            if (white) generate_legal_moves<WHITE>(pos, moves);
+            else generate_legal_moves<BLACK>(pos, moves);
+            break;
+    }
+}
+
+// Popcount of the legal targets of every unpinned piece of type 'Pt'
+template <Color Us, PieceType Pt>
+static inline int count_piece_moves(const Position &pos, Bitboard all_occ,
+    Bitboard targets, const LegalMasks &lm) {
+    Bitboard pieces = pos.pieces[make_piece(Us, Pt)] & ~lm.pinned;
+    int count = 0;
+    while (pieces) {
+        int from = get_lsb_index(pop_lsb(pieces));
+        count += popcount(piece_attacks<Pt>(from, all_occ) & targets);
+    }
+    return count;
+}
+
+template <Color Us>
+int count_legal_moves(const Position &pos) {
+    using S = Side<Us>;
+    constexpr Color Them = S::Them;
+    Bitboard own_occ = pos.occupancies[Us];
+    Bitboard opp_occ = pos.occupancies[Them];
+    Bitboard all_occ = pos.occupied();
+    STAT_INC(CountCalls);
+    LegalMasks lm = compute_legal_masks<Us>(pos);
+    int count = 0;
+
+    // King moves still need one attack test per target square
+    Bitboard king_occ = all_occ ^ (1ULL << lm.king_sq);
+    Bitboard king_targets = king_attacks[lm.king_sq] & ~own_occ;
+    while (king_targets) {
+        int to = get_lsb_index(pop_lsb(king_targets));
+        STAT_INC(AttackChecksLegality);
+        if (!is_square_attacked<Them>(pos, to, king_occ)) count++;
+        else STAT_INC(KingTargetsRejected);
     }
+    if (lm.checkers & (lm.checkers - 1)) {
+        STAT_ADD(MovesCounted, count);
+        return count;
+    }
+
+    Bitboard targets = ~own_occ & lm.check_mask;
+
+    // Pawns: set-wise target popcounts, promotions count four times
+    Bitboard pawns = pos.pieces[S::Pawn];
+    count += count_pawn_targets<Us>(PawnTargets<Us>(pawns & ~lm.pinned, opp_occ, all_occ,
+                                                    lm.check_mask));
+    Bitboard pinned = pawns & lm.pinned;
+    while (pinned) {
+        Bitboard b = pop_lsb(pinned);
+        int from = get_lsb_index(b);
+        count += count_pawn_targets<Us>(PawnTargets<Us>(b, opp_occ, all_occ,
+                                                        legal_targets(lm, from)));
+    }
+    Bitboard ep = en_passant_capturers<Us>(pos);
+    while (ep) {
+        int from = get_lsb_index(pop_lsb(ep));
+        if (en_passant_is_legal<Us>(pos, lm, from, pos.en_passant)) count++;
+        else STAT_INC(EnPassantRejected);
+    }
+
+    // Pinned knights never move; others are a popcount of their targets
+    count += count_piece_moves<Us, KNIGHT>(pos, all_occ, targets, lm);
+    count += count_piece_moves<Us, BISHOP>(pos, all_occ, targets, lm);
+    count += count_piece_moves<Us, ROOK>(pos, all_occ, targets, lm);
+    count += count_piece_moves<Us, QUEEN>(pos, all_occ, targets, lm);
+    // Pinned sliders may only move along the pin line
+    Bitboard diag = diagonal_sliders<Us>(pos);
+    Bitboard orth = orthogonal_sliders<Us>(pos);
+    Bitboard b = (diag | orth) & lm.pinned;
+    while (b) {
+        int from = get_lsb_index(pop_lsb(b));
+        Bitboard att = 0;
+        if (diag & (1ULL << from)) att |= bishop_attacks(from, all_occ);
+        if (orth & (1ULL << from)) att |= rook_attacks(from, all_occ);
+        count += popcount(att & targets & line_bb[lm.king_sq][from]);
+    }
+
+    if (!lm.checkers) {
+        count += can_castle<Us, S::FirstRight>(pos, all_occ);
+        count += can_castle<Us, S::FirstRight + 1>(pos, all_occ);
+    }
+    STAT_ADD(MovesCounted, count);
+    return count;
+}
+
+template int count_legal_moves<WHITE>(const Position &);
+template int count_legal_moves<BLACK>(const Position &);
+
+int count_legal_moves(const Position &pos) {
+    return pos.side_to_move == WHITE ? count_legal_moves<WHITE>(pos)
+                                     : count_legal_moves<BLACK>(pos);
 }
 
-} // namespace chess
\ No newline at end of file
+} // namespace chess
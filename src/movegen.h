@@ -3,12 +3,62 @@
 
  #include "position.h"
  #include "types.h"
+ #include <iosfwd>
+ #include <string>
  #include <vector>
 
 namespace chess {
 
+// Which legal moves to generate. Captures include en passant and every
+// promotion, capturing or not; quiets are the rest, castling included.
+// In check either class is limited to evasions, so the two together
+// always make up GEN_ALL.
+enum GenType { GEN_ALL, GEN_CAPTURES, GEN_QUIETS };
+
 // Generate all legal moves for the given position
-void generate_legal_moves(const Position &pos, std::vector<Move> &moves);
+void generate_legal_moves(const Position &pos, MoveList &moves);
+// Generate one class of legal moves
+void generate_legal_moves(const Position &pos, MoveList &moves, GenType type);
+
+// Count the legal moves without generating or playing them; used for
+// perft leaves
+int count_legal_moves(const Position &pos);
+
+// Determine if square 'sq' is attacked by side 'by' in the current position
+bool is_square_attacked(const Position &pos, int sq, Color by);
+
+// True if the side to move is in check
+bool in_check(const Position &pos);
+
+// Whether 'm' could be played here ignoring king safety: a piece of the
+// side to move on m.from() that moves that way, with flags matching the
+// board (capture, en passant, double push, castling right and empty path).
+// Any 16-bit value is accepted, so moves from the hash table, killers or
+// other positions can be screened without generating.
+bool is_pseudo_legal(const Position &pos, Move m);
+
+// Whether 'm' is one of generate_legal_moves' moves, in constant time:
+// is_pseudo_legal plus a king safety test from the cached checkers and pins
+bool is_legal(const Position &pos, Move m);
+
+// Long algebraic (UCI) notation, e.g. "e2e4" or "e7e8q"; "0000" for Move(0)
+std::string move_to_uci(Move m);
+
+// The legal move written as 'text' in long algebraic notation, with its
+// capture, en passant, double push or castling flag set from the board;
+// Move(0, 0) if 'text' is malformed or names no legal move
+Move move_from_uci(const Position &pos, const std::string &text);
+
+// Check is_legal on every 16-bit move value and move_from_uci on every
+// legal move against generate_legal_moves; reports mismatches and a summary.
+bool verify_move_legality(const std::vector<Position> &positions, std::ostream &out);
+
+// Variants for a side to move known at compile time, so recursive callers
+// can skip the color dispatch. generate_legal_moves<Us> appends to 'moves'.
+template <Color Us, GenType Type = GEN_ALL>
+void generate_legal_moves(const Position &pos, MoveList &moves);
+template <Color Us>
+int count_legal_moves(const Position &pos);
 
 } // namespace chess
 
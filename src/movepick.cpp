@@ -0,0 +1,194 @@
+ #include "movepick.h"
+ #include "bitboard.h"
+ #include "evaluate.h"
+ #include <algorithm>
+
+namespace chess {
+
+// The king is worth more than anything it could win, so SEE never lets it
+// capture into a defended square
+static constexpr int see_value[6] = {100, 320, 330, 500, 900, 20000};
+
+int see(const Position &pos, Move m) {
+    if (m.is_castling()) return 0;
+    int from = m.from(), to = m.to();
+    Color us = pos.side_to_move;
+    Bitboard occ = pos.occupied() ^ (1ULL << from);
+    int gain[32];
+    gain[0] = m.is_en_passant() ? see_value[PAWN]
+            : m.is_capture()    ? see_value[pos.board[to] % 6]
+                                : 0;
+    PieceType on_square = PieceType(pos.board[from] % 6);
+    if (m.is_promotion()) {
+        on_square = m.promotion_type();
+        gain[0] += see_value[on_square] - see_value[PAWN];
+    }
+    if (m.is_en_passant()) occ ^= 1ULL << (to - (us == WHITE ? 8 : -8));
+
+    Bitboard diagonal = pos.pieces[WB] | pos.pieces[WQ] | pos.pieces[BB] | pos.pieces[BQ];
+    Bitboard orthogonal = pos.pieces[WR] | pos.pieces[WQ] | pos.pieces[BR] | pos.pieces[BQ];
+    Bitboard attackers = attackers_to(pos, to, occ) & occ;
+    Color side = Color(us ^ 1);
+    int d = 0;
+    while (d < 31) {
+        Bitboard ours = attackers & pos.occupancies[side];
+        if (!ours) break;
+        PieceType pt = PAWN;
+        Bitboard b = 0;
+        for (; pt <= KING; pt = PieceType(pt + 1))
+            if ((b = ours & pos.pieces[make_piece(side, pt)])) break;
+        // Speculative store: what 'side' nets by taking the piece on the square
+        ++d;
+        gain[d] = see_value[on_square] - gain[d - 1];
+        // Neither side can profit from going on
+        if (std::max(-gain[d - 1], gain[d]) < 0) break;
+        occ ^= b & (0 - b);
+        // Sliders lined up behind the capturer join in
+        if (pt == PAWN || pt == BISHOP || pt == QUEEN)
+            attackers |= bishop_attacks(to, occ) & diagonal;
+        if (pt == ROOK || pt == QUEEN) attackers |= rook_attacks(to, occ) & orthogonal;
+        attackers &= occ;
+        on_square = pt;
+        side = Color(side ^ 1);
+    }
+    while (--d > 0) gain[d - 1] = -std::max(-gain[d - 1], gain[d]);
+    return gain[0];
+}
+
+// Most valuable victim first, least valuable attacker breaking ties;
+// promotions add the value of the new piece
+static inline int mvv_lva(const Position &pos, Move m) {
+    // A quiet promotion captures nothing, not a pawn
+    int victim_value = m.is_en_passant() ? piece_value[PAWN]
+                       : m.is_capture()  ? piece_value[pos.board[m.to()] % 6]
+                                         : 0;
+    int attacker = pos.board[m.from()] % 6;
+    int score = victim_value * 8 - attacker;
+    if (m.is_promotion()) score += piece_value[m.promotion_type()];
+    return score;
+}
+
+MovePicker::MovePicker(const Position &pos, Move hash_move, const Move *killers,
+                       const int (*history)[64])
+    : pos_(pos), history_(history), hash_move_(hash_move), stage_(HASH) {
+    killers_[0] = killers[0];
+    killers_[1] = killers[1];
+}
+
+MovePicker::MovePicker(const Position &pos) : pos_(pos), stage_(QS_CAPTURES_INIT) {}
+
+// Generate one class into moves_ and score it for pick_best
+void MovePicker::generate(GenType type) {
+    generate_legal_moves(pos_, moves_, type);
+    for (int i = 0; i < moves_.size(); ++i) {
+        Move m = moves_[i];
+        scores_[i] = type == GEN_CAPTURES ? mvv_lva(pos_, m)
+                                          : history_[pos_.board[m.from()]][m.to()];
+    }
+    cur_ = 0;
+}
+
+Move MovePicker::pick_best() {
+    MoveList &moves = moves_;
+    int best = cur_;
+    for (int j = cur_ + 1; j < moves.size(); ++j)
+        if (scores_[j] > scores_[best]) best = j;
+    std::swap(moves.moves[cur_], moves.moves[best]);
+    std::swap(scores_[cur_], scores_[best]);
+    return moves.moves[cur_++];
+}
+
+bool MovePicker::is_hash_or_killer(Move m) const {
+    return m == hash_move_ || m == killers_[0] || m == killers_[1];
+}
+
+Move MovePicker::next() {
+    switch (stage_) {
+    case HASH:
+        stage_ = CAPTURES_INIT;
+        // A stale or colliding entry may hold a move that is not legal here
+        if (hash_move_ != Move(0, 0) && is_legal(pos_, hash_move_)) return hash_move_;
+        hash_move_ = Move(0, 0);
+        [[fallthrough]];
+
+    case CAPTURES_INIT:
+        generate(GEN_CAPTURES);
+        stage_ = GOOD_CAPTURES;
+        [[fallthrough]];
+
+    case GOOD_CAPTURES:
+        while (cur_ < moves_.size()) {
+            Move m = pick_best();
+            if (m == hash_move_) continue;
+            // Losing captures wait until the quiet moves have been tried
+            if (!m.is_promotion() && see(pos_, m) < 0) {
+                bad_captures_.push_back(m);
+                continue;
+            }
+            return m;
+        }
+        stage_ = KILLERS;
+        [[fallthrough]];
+
+    case KILLERS:
+        // Killers come from sibling nodes and are only played if they are
+        // legal here; one that now captures was already tried as a capture
+        while (killer_index_ < 2) {
+            Move k = killers_[killer_index_++];
+            if (k != Move(0, 0) && k != hash_move_ && is_legal(pos_, k)) return k;
+        }
+        stage_ = QUIETS_INIT;
+        [[fallthrough]];
+
+    case QUIETS_INIT:
+        generate(GEN_QUIETS);
+        stage_ = QUIETS;
+        [[fallthrough]];
+
+    case QUIETS:
+        while (cur_ < moves_.size()) {
+            Move m = pick_best();
+            if (!is_hash_or_killer(m)) return m;
+        }
+        cur_ = 0;
+        stage_ = BAD_CAPTURES;
+        [[fallthrough]];
+
+    case BAD_CAPTURES:
+        if (cur_ < bad_captures_.size()) return bad_captures_[cur_++];
+        stage_ = DONE;
+        return Move(0, 0);
+
+    case QS_CAPTURES_INIT:
+        generate(GEN_CAPTURES);
+        stage_ = QS_CAPTURES;
+        [[fallthrough]];
+
+    case QS_CAPTURES:
+        if (cur_ < moves_.size()) return pick_best();
+        if (!in_check(pos_)) {
+            stage_ = DONE;
+            return Move(0, 0);
+        }
+        stage_ = QS_EVASIONS_INIT;
+        [[fallthrough]];
+
+    case QS_EVASIONS_INIT:
+        // No history here; evasions keep generation order
+        generate_legal_moves(pos_, moves_, GEN_QUIETS);
+        cur_ = 0;
+        stage_ = QS_EVASIONS;
+        [[fallthrough]];
+
+    case QS_EVASIONS:
+        if (cur_ < moves_.size()) return moves_[cur_++];
+        stage_ = DONE;
+        [[fallthrough]];
+
+    case DONE:
+        return Move(0, 0);
+    }
+    return Move(0, 0);
+}
+
+} // namespace chess
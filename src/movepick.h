@@ -0,0 +1,60 @@
+ #ifndef CHESS_MOVEPICK_H
+ #define CHESS_MOVEPICK_H
+
+ #include "movegen.h"
+ #include "position.h"
+ #include "types.h"
+
+namespace chess {
+
+// Static exchange evaluation: the material balance, in centipawns, of
+// the capture sequence on m.to() started by 'm', each side recapturing
+// with its least valuable attacker and free to stop. Pins are ignored.
+int see(const Position &pos, Move m);
+
+// Hands out the legal moves of a position one at a time in search order,
+// generating each class only when the previous one is used up, so a node
+// that cuts off early never pays for the quiet moves it did not try.
+//
+// Main search order: hash move, captures and promotions with SEE >= 0 by
+// MVV-LVA, killers, quiet moves by history, losing captures.
+// Quiescence order: captures and promotions by MVV-LVA, then, in check
+// only, the quiet evasions.
+class MovePicker {
+public:
+    // 'killers' holds two moves, 'history' is indexed [piece][to]
+    MovePicker(const Position &pos, Move hash_move, const Move *killers,
+               const int (*history)[64]);
+    explicit MovePicker(const Position &pos);
+
+    // The next move, or Move(0, 0) when all have been returned
+    Move next();
+
+private:
+    enum Stage {
+        HASH, CAPTURES_INIT, GOOD_CAPTURES, KILLERS, QUIETS_INIT, QUIETS, BAD_CAPTURES,
+        QS_CAPTURES_INIT, QS_CAPTURES, QS_EVASIONS_INIT, QS_EVASIONS, DONE
+    };
+
+    void generate(GenType type);
+    // Move the best-scored remaining move to position cur_ and return it
+    Move pick_best();
+    bool is_hash_or_killer(Move m) const;
+
+    const Position &pos_;
+    const int (*history_)[64] = nullptr;
+    Move hash_move_ = Move(0, 0);
+    Move killers_[2] = {Move(0, 0), Move(0, 0)};
+    int stage_;
+    int killer_index_ = 0;
+
+    // The class being handed out; losing captures are set aside until
+    // after the quiet moves
+    MoveList moves_, bad_captures_;
+    int scores_[256];
+    int cur_ = 0;
+};
+
+} // namespace chess
+
+#endif // CHESS_MOVEPICK_H
@@ -1,20 +1,230 @@
  #include "perft.h"
  #include "movegen.h"
+ #include "bitboard.h"
+ #include "stats.h"
+ #include "thread_pool.h"
+ #include <atomic>
+ #include <memory>
  #include <vector>
 
 namespace chess {
 
+// Leaf count one ply below 'pos'. Instrumented builds play out the last
+// ply so each leaf move can be classified; bulk counting never sees them.
+template <Color Us>
+static inline uint64_t perft_leaf(Position &pos) {
+#if defined(ENABLE_STATS)
+    constexpr Color Them = Us == WHITE ? BLACK : WHITE;
+    MoveList moves;
+    generate_legal_moves<Us>(pos, moves);
+    UndoInfo undo;
+    for (Move m : moves) {
+        STAT_INC(LeafNodes);
+        if (m.is_capture()) STAT_INC(LeafCaptures);
+        if (m.is_en_passant()) STAT_INC(LeafEnPassant);
+        if (m.is_castling()) STAT_INC(LeafCastles);
+        if (m.is_promotion()) STAT_INC(LeafPromotions);
+        make_move(pos, m, undo);
+        STAT_INC(MovesMade);
+        int king_sq = get_lsb_index(pos.pieces[make_piece(Them, KING)]);
+        if (is_square_attacked(pos, king_sq, Us)) {
+            STAT_INC(LeafChecks);
+            if (count_legal_moves<Them>(pos) == 0) STAT_INC(LeafCheckmates);
+        }
+        unmake_move(pos, m, undo);
+    }
+    return moves.size();
+#else
+    return count_legal_moves<Us>(pos);
+#endif
+}
+
+// Walks the tree on one mutable position, taking back each move after use.
+// The side to move alternates at compile time, so no ply dispatches on color.
+template <Color Us>
+static uint64_t perft_recursive(Position &pos, int depth) {
+    if (depth == 0) return 1;
+    if (depth == 1) return perft_leaf<Us>(pos);
+    MoveList moves;
+    generate_legal_moves<Us>(pos, moves);
+    uint64_t nodes = 0;
+    UndoInfo undo;
+    for (Move m : moves) {
+        make_move(pos, m, undo);
+        STAT_INC(MovesMade);
+        nodes += perft_recursive<Us == WHITE ? BLACK : WHITE>(pos, depth - 1);
+        unmake_move(pos, m, undo);
+    }
+    return nodes;
+}
+
+static uint64_t perft_recursive(Position &pos, int depth) {
+    return pos.side_to_move == WHITE ? perft_recursive<WHITE>(pos, depth)
+                                     : perft_recursive<BLACK>(pos, depth);
+}
+
 uint64_t perft(const Position &pos, int depth) {
+    Position root = pos;
+    STAT_INC(PositionCopies);
+    return perft_recursive(root, depth);
+}
+
+// Hashed perft entry: leaf count of the subtree below (key, depth).
+// The depth lives in the low 8 bits of 'data', the count above it. The
+// stored key is XORed with the data so threads can share the table
+// without locks: a torn write fails verification and reads as a miss.
+struct PerftEntry {
+    std::atomic<uint64_t> key_xor_data;
+    std::atomic<uint64_t> data;
+};
+
+// One cache line of entries sharing a table index
+struct alignas(64) PerftBucket {
+    PerftEntry entries[4];
+};
+
+PerftTable::PerftTable() = default;
+
+PerftTable::PerftTable(size_t table_mb) {
+    resize(table_mb);
+}
+
+PerftTable::~PerftTable() = default;
+
+void PerftTable::resize(size_t table_mb) {
+    size_t count = 1;
+    while (count * 2 * sizeof(PerftBucket) <= table_mb * 1024 * 1024) count *= 2;
+    buckets.reset(new PerftBucket[count]);
+    for (size_t i = 0; i < count; ++i) {
+        for (PerftEntry &e : buckets[i].entries) {
+            e.key_xor_data.store(0, std::memory_order_relaxed);
+            e.data.store(0, std::memory_order_relaxed);
+        }
+    }
+    mask = count - 1;
+}
+
+static inline bool probe_perft_table(const PerftTable &tt, uint64_t key, int depth,
+    uint64_t &nodes) {
+    const PerftBucket &b = tt.buckets[key & tt.mask];
+    for (const PerftEntry &e : b.entries) {
+        uint64_t data = e.data.load(std::memory_order_relaxed);
+        uint64_t check = e.key_xor_data.load(std::memory_order_relaxed);
+        if ((check ^ data) == key && int(data & 0xFF) == depth) {
+            nodes = data >> 8;
+            return true;
+        }
+    }
+    return false;
+}
+
+// Replace the entry holding the shallowest subtree, which is cheapest to recompute
+static inline void store_perft_table(PerftTable &tt, uint64_t key, int depth,
+    uint64_t nodes) {
+    PerftBucket &b = tt.buckets[key & tt.mask];
+    PerftEntry *victim = &b.entries[0];
+    uint64_t victim_depth = victim->data.load(std::memory_order_relaxed) & 0xFF;
+    for (PerftEntry &e : b.entries) {
+        uint64_t d = e.data.load(std::memory_order_relaxed) & 0xFF;
+        if (d < victim_depth) {
+            victim = &e;
+            victim_depth = d;
+        }
+    }
+    uint64_t data = (nodes << 8) | uint64_t(depth);
+    victim->key_xor_data.store(key ^ data, std::memory_order_relaxed);
+    victim->data.store(data, std::memory_order_relaxed);
+}
+
+template <Color Us>
+static uint64_t perft_hashed_recursive(Position &pos, int depth, PerftTable &tt) {
     if (depth == 0) return 1;
-    std::vector<Move> moves;
-    generate_legal_moves(pos, moves);
+    if (depth == 1) return perft_leaf<Us>(pos);
     uint64_t nodes = 0;
-    for (const Move &m : moves) {
-        Position new_pos = pos;
-        make_move(new_pos, m);
-        nodes += perft(new_pos, depth - 1);
+    if (probe_perft_table(tt, pos.key, depth, nodes)) return nodes;
+    MoveList moves;
+    generate_legal_moves<Us>(pos, moves);
+    UndoInfo undo;
+    for (Move m : moves) {
+        make_move(pos, m, undo);
+        STAT_INC(MovesMade);
+        nodes += perft_hashed_recursive<Us == WHITE ? BLACK : WHITE>(pos, depth - 1, tt);
+        unmake_move(pos, m, undo);
+    }
+    store_perft_table(tt, pos.key, depth, nodes);
+    return nodes;
+}
+
+static uint64_t perft_hashed_recursive(Position &pos, int depth, PerftTable &tt) {
+    return pos.side_to_move == WHITE ? perft_hashed_recursive<WHITE>(pos, depth, tt)
+                                     : perft_hashed_recursive<BLACK>(pos, depth, tt);
+}
+
+uint64_t perft_hashed(const Position &pos, int depth, size_t table_mb) {
+    PerftTable tt(table_mb);
+    Position root = pos;
+    STAT_INC(PositionCopies);
+    return perft_hashed_recursive(root, depth, tt);
+}
+
+// A subtree left to count once the tree is expanded to the split depth
+struct PerftTask {
+    Position pos;
+    int depth;
+};
+
+// Expand 'depth' plies below 'pos' into tasks, each still 'remaining' plies deep
+static void collect_perft_tasks(Position &pos, int depth, int remaining,
+    std::vector<PerftTask> &tasks) {
+    if (depth == 0) {
+        tasks.push_back({pos, remaining});
+        STAT_INC(PositionCopies);
+        return;
+    }
+    MoveList moves;
+    generate_legal_moves(pos, moves);
+    UndoInfo undo;
+    for (Move m : moves) {
+        make_move(pos, m, undo);
+        STAT_INC(MovesMade);
+        collect_perft_tasks(pos, depth - 1, remaining, tasks);
+        unmake_move(pos, m, undo);
+    }
+}
+
+uint64_t perft_parallel(const Position &pos, int depth, int threads, int split_depth,
+    size_t table_mb) {
+    if (split_depth >= depth) split_depth = depth - 1;
+    if (split_depth < 1 || threads < 1) threads = 1;
+    if (threads == 1) return table_mb ? perft_hashed(pos, depth, table_mb) : perft(pos, depth);
+
+    PerftTable tt;
+    if (table_mb) tt.resize(table_mb);
+    return perft_parallel(pos, depth, threads, split_depth, table_mb ? &tt : nullptr);
+}
+
+uint64_t perft_parallel(const Position &pos, int depth, int threads, int split_depth,
+    PerftTable *table, const std::atomic<bool> *stop) {
+    if (split_depth >= depth) split_depth = depth - 1;
+    if (split_depth < 1) {
+        Position root = pos;
+        return table ? perft_hashed_recursive(root, depth, *table) : perft_recursive(root, depth);
     }
+    std::vector<PerftTask> tasks;
+    Position root = pos;
+    collect_perft_tasks(root, split_depth, depth - split_depth, tasks);
+
+    // Each task writes its own slot, so the total does not depend on scheduling
+    std::vector<uint64_t> counts(tasks.size());
+    parallel_for(tasks.size(), threads, [&](size_t i, int) {
+        if (stop && stop->load(std::memory_order_relaxed)) return;
+        PerftTask &t = tasks[i];
+        counts[i] = table ? perft_hashed_recursive(t.pos, t.depth, *table)
+                          : perft_recursive(t.pos, t.depth);
+    });
+    uint64_t nodes = 0;
+    for (uint64_t c : counts) nodes += c;
     return nodes;
 }
 
-} // namespace chess
\ No newline at end of file
+} // namespace chess
@@ -2,13 +2,47 @@
  #define CHESS_PERFT_H
 
  #include "position.h"
+ #include <atomic>
  #include <cstdint>
+ #include <cstddef>
+ #include <memory>
 
 namespace chess {
 
 // Perft calculates the number of leaf nodes at a given search depth
 uint64_t perft(const Position &pos, int depth);
 
+struct PerftBucket;
+
+// Hashed perft table. Entries are keyed by position and remaining depth,
+// so a table stays valid across runs and positions and can be kept by a
+// long-lived caller.
+struct PerftTable {
+    PerftTable();
+    explicit PerftTable(size_t table_mb);
+    ~PerftTable();
+    void resize(size_t table_mb);
+
+    std::unique_ptr<PerftBucket[]> buckets;
+    uint64_t mask = 0;
+};
+
+// Perft with a transposition table of 'table_mb' megabytes that caches
+// subtree counts by Zobrist key and remaining depth
+uint64_t perft_hashed(const Position &pos, int depth, size_t table_mb);
+
+// Perft on 'threads' workers. The tree is expanded 'split_depth' plies
+// below the root and each resulting subtree becomes one task. With
+// 'table_mb' > 0 all workers share one lock-free hash table.
+uint64_t perft_parallel(const Position &pos, int depth, int threads, int split_depth,
+    size_t table_mb);
+
+// As above with a caller-owned table (may be null for no hashing). When
+// 'stop' is set workers give up after their current task; the returned
+// count is then incomplete.
+uint64_t perft_parallel(const Position &pos, int depth, int threads, int split_depth,
+    PerftTable *table, const std::atomic<bool> *stop = nullptr);
+
 } // namespace chess
 
 #endif // CHESS_PERFT_H
\ No newline at end of file
@@ -0,0 +1,411 @@
+ #include "pgn.h"
+ #include "bitboard.h"
+ #include "corpus.h"
+ #include "fen.h"
+ #include "movegen.h"
+ #include "thread_pool.h"
+ #include <algorithm>
+ #include <chrono>
+ #include <cstring>
+ #include <fstream>
+ #include <iomanip>
+ #include <ostream>
+ #include <fcntl.h>
+ #include <sys/mman.h>
+ #include <sys/stat.h>
+ #include <unistd.h>
+
+namespace chess {
+
+// Games replayed per parallel block, and diagnostics printed in full
+static constexpr size_t pgn_block_games = 4096;
+static constexpr uint64_t pgn_max_reported = 20;
+
+static inline int parse_square(std::string_view s) {
+    if (s.size() != 2 || s[0] < 'a' || s[0] > 'h' || s[1] < '1' || s[1] > '8') return -1;
+    return (s[1] - '1') * 8 + (s[0] - 'a');
+}
+
+static inline int piece_letter(char c) {
+    const char *p = c ? std::strchr("NBRQK", c) : nullptr;
+    return p ? KNIGHT + int(p - "NBRQK") : -1;
+}
+
+static Move castling_from_san(const Position &pos, bool queen_side) {
+    int from = pos.side_to_move == WHITE ? 4 : 60;
+    Move m(from, queen_side ? from - 2 : from + 2, CASTLING);
+    return is_legal(pos, m) ? m : Move(0, 0);
+}
+
+Move move_from_san(const Position &pos, std::string_view san) {
+    while (!san.empty() && std::strchr("+#!?", san.back())) san.remove_suffix(1);
+    if (san == "O-O" || san == "0-0") return castling_from_san(pos, false);
+    if (san == "O-O-O" || san == "0-0-0") return castling_from_san(pos, true);
+    if (san.size() < 2) return Move(0, 0);
+
+    Color us = pos.side_to_move;
+    int pt = piece_letter(san[0]);
+    if (pt < 0) pt = PAWN;
+    else san.remove_prefix(1);
+    // Promotion, written "e8=Q" or "e8Q"
+    int promo = -1;
+    if (pt == PAWN && san.size() >= 3 && piece_letter(san.back()) > PAWN) {
+        promo = piece_letter(san.back());
+        san.remove_suffix(san[san.size() - 2] == '=' ? 2 : 1);
+    }
+    if (promo == KING || san.size() < 2) return Move(0, 0);
+    int to = parse_square(san.substr(san.size() - 2));
+    if (to < 0) return Move(0, 0);
+
+    // What is left names the origin file and/or rank
+    int from_file = -1, from_rank = -1;
+    for (char c : san.substr(0, san.size() - 2)) {
+        if (c >= 'a' && c <= 'h') from_file = c - 'a';
+        else if (c >= '1' && c <= '8') from_rank = c - '1';
+        else if (c != 'x' && c != '-') return Move(0, 0);
+    }
+
+    bool capture = pt == PAWN && from_file >= 0 && from_file != to % 8;
+    Bitboard occ = pos.occupied();
+    Bitboard ours = pos.pieces[make_piece(us, PieceType(pt))];
+    Bitboard candidates;
+    int push = us == WHITE ? 8 : -8;
+    switch (pt) {
+        case PAWN:
+            // Only a capture leaves the file; long algebraic pushes such as
+            // "e2-e4" name the origin file too
+            if (capture) {
+                candidates = pawn_attacks[us ^ 1][to] & ours;
+            } else if (to - push >= 0 && to - push < 64 && pos.board[to - push] != NO_PIECE) {
+                candidates = ours & (1ULL << (to - push));
+            } else {
+                int from = to - 2 * push;
+                candidates = from >= 0 && from < 64 ? ours & (1ULL << from) : 0;
+            }
+            break;
+        case KNIGHT: candidates = knight_attacks[to] & ours; break;
+        case BISHOP: candidates = bishop_attacks(to, occ) & ours; break;
+        case ROOK: candidates = rook_attacks(to, occ) & ours; break;
+        case QUEEN: candidates = queen_attacks(to, occ) & ours; break;
+        default: candidates = king_attacks[to] & ours; break;
+    }
+    if (from_file >= 0) candidates &= file_bb(from_file);
+    if (from_rank >= 0) candidates &= rank_bb(from_rank);
+
+    int flags = pos.board[to] != NO_PIECE ? CAPTURE : QUIET;
+    Move found = Move(0, 0);
+    while (candidates) {
+        int from = get_lsb_index(pop_lsb(candidates));
+        int f = flags;
+        if (pt == PAWN) {
+            if (to == pos.en_passant && capture) f = EN_PASSANT;
+            else if (to - from == 2 * push) f = DOUBLE_PUSH;
+            if (promo > 0) f = (f & CAPTURE) | PROMOTION | (promo - KNIGHT);
+        }
+        Move m(from, to, f);
+        if (!is_legal(pos, m)) continue;
+        if (found != Move(0, 0)) return Move(0, 0);
+        found = m;
+    }
+    return found;
+}
+
+PgnReader::~PgnReader() {
+    close();
+}
+
+bool PgnReader::open(const std::string &path) {
+    close();
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) return false;
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        ::close(fd);
+        return false;
+    }
+    size_ = size_t(st.st_size);
+    // An empty file has no games and cannot be mapped
+    if (size_ == 0) {
+        ::close(fd);
+        return true;
+    }
+    void *map = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (map == MAP_FAILED) {
+        size_ = 0;
+        return false;
+    }
+    map_ = static_cast<const char *>(map);
+    madvise(map, size_, MADV_SEQUENTIAL);
+    return true;
+}
+
+void PgnReader::close() {
+    if (map_) munmap(const_cast<char *>(map_), size_);
+    map_ = nullptr;
+    size_ = offset_ = 0;
+    line_ = 1;
+}
+
+static inline bool is_blank(char c) {
+    return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+}
+
+bool PgnReader::next(PgnGameText &game) {
+    for (; offset_ < size_ && is_blank(map_[offset_]); ++offset_)
+        if (map_[offset_] == '\n') ++line_;
+    if (offset_ >= size_) return false;
+
+    size_t start = offset_;
+    game.line = line_;
+    bool movetext = false;
+    int braces = 0;
+    while (offset_ < size_) {
+        const char *p = map_ + offset_;
+        const char *nl = static_cast<const char *>(std::memchr(p, '\n', size_ - offset_));
+        size_t len = nl ? size_t(nl - p) : size_ - offset_;
+        size_t k = 0;
+        while (k < len && is_blank(p[k])) ++k;
+        // A tag line after the movetext starts the next game, unless it is
+        // inside a comment
+        if (k < len && braces == 0) {
+            if (p[k] != '[') movetext = true;
+            else if (movetext) break;
+        }
+        if (movetext) {
+            for (size_t i = k; i < len; ++i) {
+                if (p[i] == '{') ++braces;
+                else if (p[i] == '}' && braces > 0) --braces;
+                else if (p[i] == ';' && braces == 0) break;
+            }
+        }
+        offset_ += len + (nl ? 1 : 0);
+        if (nl) ++line_;
+    }
+    game.text = std::string_view(map_ + start, offset_ - start);
+    return true;
+}
+
+static bool is_result(std::string_view token) {
+    return token == "1-0" || token == "0-1" || token == "1/2-1/2" || token == "*";
+}
+
+// Parse one '[Name "Value"]' tag starting at text[i]; returns the index
+// just past its ']', or npos if it is malformed. Several tags may share
+// a line.
+static size_t parse_tag(std::string_view text, size_t i, std::string_view &name,
+    std::string &value) {
+    size_t n = text.size(), j = i + 1;
+    while (j < n && !is_blank(text[j]) && text[j] != '"' && text[j] != ']') ++j;
+    name = text.substr(i + 1, j - i - 1);
+    while (j < n && (text[j] == ' ' || text[j] == '\t')) ++j;
+    if (name.empty() || j >= n || text[j] != '"') return std::string_view::npos;
+    value.clear();
+    for (++j; j < n && text[j] != '"'; ++j) {
+        if (text[j] == '\n') return std::string_view::npos;
+        if (text[j] == '\\' && j + 1 < n) ++j;
+        value += text[j];
+    }
+    for (++j; j < n && (text[j] == ' ' || text[j] == '\t'); ++j) {}
+    return j < n && text[j] == ']' ? j + 1 : std::string_view::npos;
+}
+
+bool parse_pgn_game(std::string_view text, PgnGame &game, std::string &error) {
+    init_position(game.start);
+    game.moves.clear();
+    game.result = "*";
+    size_t i = 0, n = text.size();
+
+    std::string value;
+    while (true) {
+        while (i < n && is_blank(text[i])) ++i;
+        // The rest of a tag line may be a comment
+        if (i < n && text[i] == ';') {
+            i = std::min(text.find('\n', i), n);
+            continue;
+        }
+        if (i >= n || text[i] != '[') break;
+        std::string_view name;
+        size_t end = parse_tag(text, i, name, value);
+        if (end == std::string_view::npos) {
+            error = "malformed tag";
+            return false;
+        }
+        if (name == "FEN") {
+            FenError err = parse_fen(value, game.start);
+            if (err != FenError::None) {
+                error = std::string("bad FEN tag (") + fen_error_string(err) + ")";
+                return false;
+            }
+        } else if (name == "Result") {
+            game.result = value;
+        }
+        i = end;
+    }
+
+    Position pos = game.start;
+    while (i < n) {
+        char c = text[i];
+        if (is_blank(c)) {
+            ++i;
+        } else if (c == '{') {
+            size_t close = text.find('}', i);
+            if (close == std::string_view::npos) {
+                error = "unterminated comment";
+                return false;
+            }
+            i = close + 1;
+        } else if (c == ';' || c == '%') {
+            i = std::min(text.find('\n', i), n);
+        } else if (c == '(') {
+            // Variations may nest and hold comments of either kind
+            int depth = 0;
+            for (; i < n; ++i) {
+                if (text[i] == '{') i = std::min(text.find('}', i), n - 1);
+                else if (text[i] == ';') i = std::min(text.find('\n', i), n - 1);
+                else if (text[i] == '(') ++depth;
+                else if (text[i] == ')' && --depth == 0) break;
+            }
+            if (depth != 0) {
+                error = "unterminated variation";
+                return false;
+            }
+            ++i;
+        } else if (c == '$') {
+            for (++i; i < n && text[i] >= '0' && text[i] <= '9'; ++i) {}
+        } else {
+            size_t j = i;
+            while (j < n && !is_blank(text[j]) && !std::strchr("{}();$", text[j])) ++j;
+            std::string_view token = text.substr(i, std::max(j, i + 1) - i);
+            i = std::max(j, i + 1);
+            if (is_result(token)) {
+                game.result = std::string(token);
+                return true;
+            }
+            // Move numbers, "12." or "12...", may be glued to the move
+            size_t digits = 0;
+            while (digits < token.size() && token[digits] >= '0' && token[digits] <= '9') ++digits;
+            if (digits > 0 && digits < token.size() && token[digits] == '.') {
+                token.remove_prefix(digits);
+                while (!token.empty() && token[0] == '.') token.remove_prefix(1);
+            } else if (digits > 0 && digits == token.size()) {
+                token = {};
+            }
+            if (token.empty()) continue;
+            Move m = move_from_san(pos, token);
+            if (m == Move(0, 0)) {
+                error = "illegal or ambiguous move '" + std::string(token) + "' at ply " +
+                        std::to_string(game.moves.size() + 1);
+                return false;
+            }
+            make_move(pos, m);
+            game.moves.push_back(m);
+        }
+    }
+    return true;
+}
+
+namespace {
+
+// What one game contributes to the output
+struct GameOutput {
+    bool ok = false;
+    std::string error;
+    uint64_t positions = 0;
+    std::string fens;
+    std::vector<PackedPosition> records;
+};
+
+} // namespace
+
+bool replay_pgn(const std::string &path, PositionFormat format, const std::string &out_path,
+    int threads, std::ostream &log, PgnStats &stats) {
+    stats = PgnStats();
+    threads = std::max(threads, 1);
+    PgnReader reader;
+    if (!reader.open(path)) {
+        log << "Cannot open " << path << "\n";
+        return false;
+    }
+    std::ofstream fen_file;
+    CorpusWriter corpus;
+    if (format == PositionFormat::Fen) fen_file.open(out_path, std::ios::binary | std::ios::trunc);
+    if ((format == PositionFormat::Fen && !fen_file) ||
+        (format == PositionFormat::Corpus && !corpus.open(out_path, CorpusPayload::None))) {
+        log << "Cannot write " << out_path << "\n";
+        return false;
+    }
+
+    std::vector<PgnGameText> block;
+    std::vector<GameOutput> outputs(pgn_block_games);
+    std::vector<PgnGame> scratch(threads);
+    auto start = std::chrono::steady_clock::now();
+    bool written = true;
+    while (true) {
+        // Splitting is a sequential scan; replay is the parallel part
+        block.clear();
+        PgnGameText text;
+        while (block.size() < pgn_block_games && reader.next(text)) block.push_back(text);
+        if (block.empty()) break;
+
+        parallel_for(block.size(), threads, [&](size_t i, int worker) {
+            GameOutput &o = outputs[i];
+            o.error.clear();
+            o.fens.clear();
+            o.records.clear();
+            o.positions = 0;
+            PgnGame &game = scratch[worker];
+            o.ok = parse_pgn_game(block[i].text, game, o.error);
+            if (!o.ok) return;
+            Position pos = game.start;
+            for (size_t ply = 0;; ++ply) {
+                ++o.positions;
+                if (format == PositionFormat::Fen) {
+                    char fen[FEN_BUFFER_SIZE];
+                    o.fens.append(fen, write_fen(pos, fen, sizeof(fen)));
+                    o.fens += '\n';
+                } else if (format == PositionFormat::Corpus) {
+                    o.records.emplace_back();
+                    pack_position(pos, o.records.back());
+                }
+                if (ply == game.moves.size()) break;
+                make_move(pos, game.moves[ply]);
+            }
+        });
+
+        for (size_t i = 0; i < block.size(); ++i) {
+            const GameOutput &o = outputs[i];
+            ++stats.games;
+            if (!o.ok) {
+                if (++stats.skipped <= pgn_max_reported)
+                    log << "game " << stats.games << " (line " << block[i].line
+                        << "): " << o.error << ", skipped\n";
+                continue;
+            }
+            stats.positions += o.positions;
+            if (format == PositionFormat::Fen) {
+                written = written && fen_file.write(o.fens.data(), std::streamsize(o.fens.size()));
+            } else if (format == PositionFormat::Corpus) {
+                for (const PackedPosition &p : o.records) written = written && corpus.append(p);
+            }
+        }
+    }
+    if (format == PositionFormat::Fen) written = written && fen_file.flush();
+    if (format == PositionFormat::Corpus) written = corpus.close() && written;
+    stats.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    if (stats.skipped > pgn_max_reported)
+        log << stats.skipped - pgn_max_reported << " more skipped games not shown\n";
+    if (!written) {
+        log << "Error writing " << out_path << "\n";
+        return false;
+    }
+    double secs = stats.seconds > 0 ? stats.seconds : 1e-9;
+    log << "PGN: " << stats.games << " games, " << stats.skipped << " skipped, "
+        << stats.positions << " positions in " << std::fixed << std::setprecision(3)
+        << stats.seconds << " s on " << threads << " threads (" << std::setprecision(0)
+        << stats.games / secs << " games/s, " << stats.positions / secs << " positions/s)\n";
+    return true;
+}
+
+} // namespace chess
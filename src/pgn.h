@@ -0,0 +1,79 @@
+ #ifndef CHESS_PGN_H
+ #define CHESS_PGN_H
+
+ #include "corpus.h"
+ #include "position.h"
+ #include "types.h"
+ #include <cstddef>
+ #include <cstdint>
+ #include <iosfwd>
+ #include <string>
+ #include <string_view>
+ #include <vector>
+
+namespace chess {
+
+// The legal move written in standard algebraic notation, e.g. "Nbd7",
+// "exd6", "e8=Q+" or "O-O"; long algebraic forms such as "e2-e4" or
+// "Ng1f3" are accepted too. Candidates come from the attack tables and
+// the disambiguation characters and are screened with is_legal. Check and
+// annotation suffixes are ignored; Move(0, 0) if 'san' is malformed,
+// illegal or ambiguous.
+Move move_from_san(const Position &pos, std::string_view san);
+
+// One game of a PGN file: tag section and movetext, as written
+struct PgnGameText {
+    std::string_view text;
+    uint64_t line = 0;  // first line of the game, from 1
+};
+
+// Maps a PGN file read-only and splits it into games without copying.
+// A game ends where a tag line follows its movetext.
+class PgnReader {
+public:
+    PgnReader() = default;
+    PgnReader(const PgnReader &) = delete;
+    PgnReader &operator=(const PgnReader &) = delete;
+    ~PgnReader();
+
+    bool open(const std::string &path);
+    void close();
+    // The next game, or false at end of file
+    bool next(PgnGameText &game);
+
+private:
+    const char *map_ = nullptr;
+    size_t size_ = 0;
+    size_t offset_ = 0;
+    uint64_t line_ = 1;
+};
+
+struct PgnGame {
+    Position start;           // the FEN tag, or the initial position
+    std::vector<Move> moves;  // the main line; variations are skipped
+    std::string result;       // "1-0", "0-1", "1/2-1/2" or "*"
+};
+
+// Parse the tags and main line of one game, replaying the moves to
+// resolve their SAN. On failure 'error' says what and where.
+bool parse_pgn_game(std::string_view text, PgnGame &game, std::string &error);
+
+struct PgnStats {
+    uint64_t games = 0;
+    uint64_t skipped = 0;
+    uint64_t positions = 0;
+    double seconds = 0;
+};
+
+// Replay every game of the PGN file at 'path' on 'threads' workers and
+// write each game's start position and every position after a move to
+// 'out_path', games in file order. Games are read and replayed in blocks,
+// so memory use does not grow with the file. Malformed games are skipped
+// and reported to 'log'; returns false only if a file cannot be opened
+// or written.
+bool replay_pgn(const std::string &path, PositionFormat format, const std::string &out_path,
+    int threads, std::ostream &log, PgnStats &stats);
+
+} // namespace chess
+
+#endif // CHESS_PGN_H
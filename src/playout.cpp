@@ -0,0 +1,171 @@
+ #include "playout.h"
+ #include "fen.h"
+ #include "movegen.h"
+ #include "thread_pool.h"
+ #include <algorithm>
+ #include <chrono>
+ #include <fstream>
+ #include <iomanip>
+ #include <ostream>
+
+namespace chess {
+
+// Games played per parallel block; each block is written in game order
+static constexpr size_t playout_block_games = 1024;
+
+namespace {
+
+// splitmix64: an add and two multiplies per draw, and any seed will do
+struct PlayoutRng {
+    uint64_t state;
+
+    uint64_t next() {
+        uint64_t z = (state += 0x9E3779B97F4A7C15ULL);
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+        return z ^ (z >> 31);
+    }
+    // Uniform in [0, n) by multiply-shift, without a division
+    uint32_t below(uint32_t n) { return uint32_t(((next() >> 32) * n) >> 32); }
+};
+
+struct PlayoutGame {
+    GameEnd end;
+    int result;  // from white's side: 1, 0 or -1
+    uint64_t plies;
+    std::vector<Position> sampled;
+    std::string fens;
+    std::vector<PackedPosition> records;
+};
+
+// Per-worker buffers, reused from game to game
+struct PlayoutScratch {
+    PlayoutRng rng;
+    Game game;
+};
+
+} // namespace
+
+static void play_game(const Position &start, const PlayoutOptions &options,
+    PlayoutScratch &scratch, PlayoutGame &game) {
+    PlayoutRng &rng = scratch.rng;
+    Game &history = scratch.game;
+    history.reset(start);
+    const Position &pos = history.position();
+    game.sampled.clear();
+    MoveList moves;
+    while (true) {
+        if (options.sample_every <= 1 || rng.below(uint32_t(options.sample_every)) == 0)
+            game.sampled.push_back(pos);
+        generate_legal_moves(pos, moves);
+        game.end = history.end(moves.size());
+        game.result = game.end == GameEnd::Checkmate ? (pos.side_to_move == WHITE ? -1 : 1) : 0;
+        // Ongoing at the ply cap means cut off
+        if (game.end != GameEnd::Ongoing || int(history.ply()) == options.max_plies) break;
+
+        int choices = moves.size();
+        if (options.capture_bias > 0 && int(rng.below(100)) < options.capture_bias) {
+            // Move the captures to the front and draw among them
+            int captures = 0;
+            for (Move c : moves)
+                if (c.is_capture()) moves.moves[captures++] = c;
+            if (captures) choices = captures;
+        }
+        history.play(moves[rng.below(uint32_t(choices))]);
+    }
+    game.plies = history.ply();
+}
+
+static const char *result_string(int result) {
+    return result > 0 ? "1-0" : result < 0 ? "0-1" : "1/2-1/2";
+}
+
+bool run_playouts(const std::vector<Position> &starts, const PlayoutOptions &options,
+    PositionFormat format, const std::string &out_path, std::ostream &log, PlayoutStats &stats) {
+    stats = PlayoutStats();
+    int threads = std::max(options.threads, 1);
+    if (starts.empty() || options.max_plies < 0) {
+        log << "Playout needs a start position and a ply cap of at least 0\n";
+        return false;
+    }
+    std::ofstream fen_file;
+    CorpusWriter corpus;
+    if (format == PositionFormat::Fen) fen_file.open(out_path, std::ios::binary | std::ios::trunc);
+    if ((format == PositionFormat::Fen && !fen_file) ||
+        (format == PositionFormat::Corpus && !corpus.open(out_path, CorpusPayload::Score))) {
+        log << "Cannot write " << out_path << "\n";
+        return false;
+    }
+
+    std::vector<PlayoutGame> games(playout_block_games);
+    std::vector<PlayoutScratch> scratch(threads);
+    auto start = std::chrono::steady_clock::now();
+    bool written = true;
+    for (uint64_t first = 0; first < options.games; first += playout_block_games) {
+        size_t count = size_t(std::min<uint64_t>(playout_block_games, options.games - first));
+        parallel_for(count, threads, [&](size_t i, int worker) {
+            uint64_t index = first + i;
+            PlayoutScratch &s = scratch[worker];
+            s.rng.state = options.seed ^ (index * 0xD1B54A32D192ED03ULL);
+            PlayoutGame &game = games[i];
+            play_game(starts[index % starts.size()], options, s, game);
+            game.fens.clear();
+            game.records.clear();
+            if (game.end == GameEnd::Ongoing) return;
+            for (const Position &pos : game.sampled) {
+                if (format == PositionFormat::Fen) {
+                    char fen[FEN_BUFFER_SIZE];
+                    game.fens.append(fen, write_fen(pos, fen, sizeof(fen)));
+                    game.fens += " ; ";
+                    game.fens += result_string(game.result);
+                    game.fens += '\n';
+                } else if (format == PositionFormat::Corpus) {
+                    game.records.emplace_back();
+                    pack_position(pos, game.records.back());
+                }
+            }
+        });
+
+        for (size_t i = 0; i < count; ++i) {
+            const PlayoutGame &game = games[i];
+            ++stats.games;
+            stats.plies += game.plies;
+            ++stats.ends[int(game.end)];
+            if (game.end == GameEnd::Ongoing) continue;
+            stats.white_wins += game.result > 0;
+            stats.black_wins += game.result < 0;
+            stats.written += game.sampled.size();
+            if (format == PositionFormat::Fen) {
+                written = written &&
+                          fen_file.write(game.fens.data(), std::streamsize(game.fens.size()));
+            } else if (format == PositionFormat::Corpus) {
+                uint64_t payload = uint64_t(int64_t(game.result));
+                for (const PackedPosition &p : game.records)
+                    written = written && corpus.append(p, payload);
+            }
+        }
+    }
+    if (format == PositionFormat::Fen) written = written && fen_file.flush();
+    if (format == PositionFormat::Corpus) written = corpus.close() && written;
+    stats.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    if (!written) {
+        log << "Error writing " << out_path << "\n";
+        return false;
+    }
+
+    const uint64_t *e = stats.ends;
+    double secs = stats.seconds > 0 ? stats.seconds : 1e-9;
+    log << "Playout: " << stats.games << " games, " << stats.plies << " plies, "
+        << stats.written << " positions sampled\n"
+        << "  checkmate " << e[int(GameEnd::Checkmate)] << " (white " << stats.white_wins
+        << ", black " << stats.black_wins << "), stalemate " << e[int(GameEnd::Stalemate)]
+        << ", fifty moves " << e[int(GameEnd::FiftyMoves)] << ", repetition "
+        << e[int(GameEnd::Repetition)] << ", insufficient material "
+        << e[int(GameEnd::InsufficientMaterial)] << ", ply cap " << e[int(GameEnd::Ongoing)] << "\n"
+        << std::fixed << std::setprecision(3) << stats.seconds << " s on " << threads
+        << " threads (" << std::setprecision(0) << stats.games / secs << " games/s, "
+        << stats.plies / secs << " plies/s)\n";
+    return true;
+}
+
+} // namespace chess
@@ -0,0 +1,50 @@
+ #ifndef CHESS_PLAYOUT_H
+ #define CHESS_PLAYOUT_H
+
+ #include "corpus.h"
+ #include "game.h"
+ #include "position.h"
+ #include <cstdint>
+ #include <iosfwd>
+ #include <string>
+ #include <vector>
+
+namespace chess {
+
+struct PlayoutOptions {
+    uint64_t games = 1000;
+    int threads = 1;
+    int max_plies = 400;      // games still running after this many plies are cut off
+    int sample_every = 1;     // write each position with probability 1/sample_every
+    int capture_bias = 0;     // percent of moves drawn from the captures, if any
+    uint64_t seed = 1;
+};
+
+struct PlayoutStats {
+    uint64_t games = 0;
+    uint64_t plies = 0;
+    uint64_t written = 0;
+    uint64_t ends[GAME_END_COUNT] = {};  // by GameEnd; Ongoing counts ply-capped games
+    uint64_t white_wins = 0;
+    uint64_t black_wins = 0;
+    double seconds = 0;
+};
+
+// Play 'options.games' random games, game i starting from
+// starts[i % starts.size()], until mate, stalemate, the fifty-move rule,
+// threefold repetition, insufficient material or the ply cap. Every move is uniform over the
+// legal moves, except that 'capture_bias' percent of the time a capture is
+// drawn when there is one. Each game gets its own generator seeded from
+// 'seed' and its index, so the output is the same for any thread count.
+//
+// Sampled positions of finished games are written with the result from
+// white's side: "<fen> ; 1-0" lines, or corpus records whose Score payload
+// is +1, 0 or -1. Games cut off by the ply cap have no result and are not
+// written. Prints a summary with games/s to 'log'; returns false if the
+// output cannot be written.
+bool run_playouts(const std::vector<Position> &starts, const PlayoutOptions &options,
+    PositionFormat format, const std::string &out_path, std::ostream &log, PlayoutStats &stats);
+
+} // namespace chess
+
+#endif // CHESS_PLAYOUT_H
@@ -1,15 +1,166 @@
  #include "position.h"
  #include "bitboard.h"
+ #include "fen.h"
 #include <cstring>
 #include <string>
-#include <sstream>
-#include <vector>
-#include <cctype>
 
 namespace chess {
 
+// Zobrist keys, generated at compile time with splitmix64
+struct ZobristKeys {
+    uint64_t piece_square[12][64];
+    uint64_t side;
+    uint64_t castle[4];
+    uint64_t en_passant_file[8];
+};
+
+static constexpr uint64_t splitmix64(uint64_t &state) {
+    uint64_t z = (state += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+static constexpr ZobristKeys make_zobrist_keys() {
+    ZobristKeys keys{};
+    uint64_t state = 0x2545F4914F6CDD1DULL;
+    for (int p = 0; p < 12; ++p)
+        for (int sq = 0; sq < 64; ++sq)
+            keys.piece_square[p][sq] = splitmix64(state);
+    keys.side = splitmix64(state);
+    for (int i = 0; i < 4; ++i) keys.castle[i] = splitmix64(state);
+    for (int f = 0; f < 8; ++f) keys.en_passant_file[f] = splitmix64(state);
+    return keys;
+}
+
+static constexpr ZobristKeys zobrist = make_zobrist_keys();
+
+// Key contribution of every castle_rights mask
+struct CastleKeys {
+    uint64_t key[16];
+};
+
+static constexpr CastleKeys make_castle_keys() {
+    CastleKeys t{};
+    for (int mask = 0; mask < 16; ++mask)
+        for (int i = 0; i < 4; ++i)
+            if (mask & (1 << i)) t.key[mask] ^= zobrist.castle[i];
+    return t;
+}
+
+static constexpr CastleKeys castle_keys = make_castle_keys();
+
+// Rights kept when a move touches each square; only king and rook home
+// squares clear anything
+struct CastleMasks {
+    uint8_t keep[64];
+};
+
+static constexpr CastleMasks make_castle_masks() {
+    CastleMasks t{};
+    for (int sq = 0; sq < 64; ++sq) t.keep[sq] = ALL_CASTLING;
+    t.keep[4] = ALL_CASTLING & ~(WHITE_OO | WHITE_OOO);
+    t.keep[7] = ALL_CASTLING & ~WHITE_OO;
+    t.keep[0] = ALL_CASTLING & ~WHITE_OOO;
+    t.keep[60] = ALL_CASTLING & ~(BLACK_OO | BLACK_OOO);
+    t.keep[63] = ALL_CASTLING & ~BLACK_OO;
+    t.keep[56] = ALL_CASTLING & ~BLACK_OOO;
+    return t;
+}
+
+static constexpr CastleMasks castle_masks = make_castle_masks();
+
+static inline uint64_t en_passant_key(int ep) {
+    return ep < 0 ? 0 : zobrist.en_passant_file[ep % 8];
+}
+
+uint64_t compute_key(const Position &pos) {
+    uint64_t k = 0;
+    for (Bitboard b = pos.occupied(); b; ) {
+        int sq = get_lsb_index(pop_lsb(b));
+        k ^= zobrist.piece_square[pos.board[sq]][sq];
+    }
+    if (pos.side_to_move == BLACK) k ^= zobrist.side;
+    return k ^ castle_keys.key[pos.castle_rights] ^ en_passant_key(pos.en_passant);
+}
+
+// Rebuild occupancies and the mailbox from the piece bitboards
+static void refresh_derived_state(Position &pos) {
+    pos.occupancies[WHITE] = 0;
+    pos.occupancies[BLACK] = 0;
+    for (int i = 0; i < 6; ++i) pos.occupancies[WHITE] |= pos.pieces[i];
+    for (int i = 6; i < 12; ++i) pos.occupancies[BLACK] |= pos.pieces[i];
+    for (int sq = 0; sq < 64; ++sq) pos.board[sq] = NO_PIECE;
+    for (int p = WP; p <= BK; ++p) {
+        Bitboard b = pos.pieces[p];
+        while (b) pos.board[get_lsb_index(pop_lsb(b))] = Piece(p);
+    }
+}
+
+Bitboard attackers_to(const Position &pos, int sq, Bitboard occ) {
+    Bitboard diagonal = pos.pieces[WB] | pos.pieces[WQ] | pos.pieces[BB] | pos.pieces[BQ];
+    Bitboard orthogonal = pos.pieces[WR] | pos.pieces[WQ] | pos.pieces[BR] | pos.pieces[BQ];
+    return (pawn_attacks[BLACK][sq] & pos.pieces[WP]) |
+           (pawn_attacks[WHITE][sq] & pos.pieces[BP]) |
+           (knight_attacks[sq] & (pos.pieces[WN] | pos.pieces[BN])) |
+           (king_attacks[sq] & (pos.pieces[WK] | pos.pieces[BK])) |
+           (bishop_attacks(sq, occ) & diagonal) |
+           (rook_attacks(sq, occ) & orthogonal);
+}
+
+// Pieces of color 'C' that are the only blocker between its king on
+// 'king_sq' and an enemy slider
+template <Color C>
+static inline Bitboard pinned_to_king(const Position &pos, int king_sq) {
+    constexpr Color Them = C == WHITE ? BLACK : WHITE;
+    Bitboard snipers =
+        (bishop_attacks(king_sq, pos.occupancies[Them]) &
+         (pos.pieces[make_piece(Them, BISHOP)] | pos.pieces[make_piece(Them, QUEEN)])) |
+        (rook_attacks(king_sq, pos.occupancies[Them]) &
+         (pos.pieces[make_piece(Them, ROOK)] | pos.pieces[make_piece(Them, QUEEN)]));
+    Bitboard occ = pos.occupied();
+    Bitboard pinned = 0;
+    while (snipers) {
+        int s = get_lsb_index(pop_lsb(snipers));
+        Bitboard blockers = between_bb[king_sq][s] & occ;
+        if (!(blockers & (blockers - 1))) pinned |= blockers;
+    }
+    return pinned & pos.occupancies[C];
+}
+
+// Checkers and pins with 'Us' to move; both kings must be on the board
+template <Color Us>
+static inline void refresh_check_info(Position &pos) {
+    constexpr Color Them = Us == WHITE ? BLACK : WHITE;
+    int king_sq = get_lsb_index(pos.pieces[make_piece(Us, KING)]);
+    Bitboard occ = pos.occupied();
+    pos.checkers =
+        (pawn_attacks[Us][king_sq] & pos.pieces[make_piece(Them, PAWN)]) |
+        (knight_attacks[king_sq] & pos.pieces[make_piece(Them, KNIGHT)]) |
+        (bishop_attacks(king_sq, occ) &
+         (pos.pieces[make_piece(Them, BISHOP)] | pos.pieces[make_piece(Them, QUEEN)])) |
+        (rook_attacks(king_sq, occ) &
+         (pos.pieces[make_piece(Them, ROOK)] | pos.pieces[make_piece(Them, QUEEN)]));
+    pos.pinned = pinned_to_king<Us>(pos, king_sq);
+}
+
+void update_check_info(Position &pos) {
+    // Corrupt input may lack a king; such positions are never searched
+    if (!pos.pieces[WK] || !pos.pieces[BK]) {
+        pos.checkers = pos.pinned = 0;
+        return;
+    }
+    if (pos.side_to_move == WHITE) refresh_check_info<WHITE>(pos);
+    else refresh_check_info<BLACK>(pos);
+}
+
+Bitboard pinned_pieces(const Position &pos, Color c) {
+    if (c == pos.side_to_move) return pos.pinned;
+    int king_sq = get_lsb_index(pos.pieces[make_piece(c, KING)]);
+    return c == WHITE ? pinned_to_king<WHITE>(pos, king_sq) : pinned_to_king<BLACK>(pos, king_sq);
+}
+
 void init_position(Position &pos) {
-    init_attack_tables();
     std::memset(pos.pieces, 0, sizeof(pos.pieces));
     pos.pieces[WP] = 0x000000000000FF00ULL;
     pos.pieces[WN] = (1ULL<<1)|(1ULL<<6);
@@ -23,261 +174,179 @@ void init_position(Position &pos) {
     pos.pieces[BR] = (1ULL<<56)|(1ULL<<63);
     pos.pieces[BQ] = (1ULL<<59);
     pos.pieces[BK] = (1ULL<<60);
-    pos.occupancies[WHITE] = 0;
-    pos.occupancies[BLACK] = 0;
-    for (int i = 0; i < 6; ++i) pos.occupancies[WHITE] |= pos.pieces[i];
-    for (int i = 6; i < 12; ++i) pos.occupancies[BLACK] |= pos.pieces[i];
-    pos.occupancies[2] = pos.occupancies[WHITE] | pos.occupancies[BLACK];
+    refresh_derived_state(pos);
     pos.side_to_move = WHITE;
     pos.en_passant = -1;
-    pos.castle_rights = {true, true, true, true};
+    pos.castle_rights = ALL_CASTLING;
     pos.halfmove_clock = 0;
     pos.fullmove_clock = 1;
+    pos.key = compute_key(pos);
+    update_check_info(pos);
 }
 
-void make_move(Position &pos, const Move &m) {
-    Color side = pos.side_to_move;
-    Color opp = side == WHITE ? BLACK : WHITE;
-    int piece_index = -1;
-    for (int i = side*6; i < side*6+6; ++i) {
-        if (pos.pieces[i] & (1ULL<<m.from)) {
-            piece_index = i;
-            break;
-        }
-    }
-    // Remove moving piece from source square
-    pos.pieces[piece_index] &= ~(1ULL<<m.from);
+void drop_dead_en_passant(Position &pos) {
+    if (pos.en_passant < 0) return;
+    Color us = pos.side_to_move;
+    if (!(pawn_attacks[us ^ 1][pos.en_passant] & pos.pieces[make_piece(us, PAWN)]))
+        pos.en_passant = -1;
+}
 
-    // Handle castling rook move
-    if (m.castling) {
-        if (piece_index == WK) {
-            if (m.to == 6) {
-                pos.pieces[WR] &= ~(1ULL<<7);
-                pos.pieces[WR] |= (1ULL<<5);
-            } else if (m.to == 2) {
-                pos.pieces[WR] &= ~(1ULL<<0);
-                pos.pieces[WR] |= (1ULL<<3);
-            }
-        } else if (piece_index == BK) {
-            if (m.to == 62) {
-                pos.pieces[BR] &= ~(1ULL<<63);
-                pos.pieces[BR] |= (1ULL<<61);
-            } else if (m.to == 58) {
-                pos.pieces[BR] &= ~(1ULL<<56);
-                pos.pieces[BR] |= (1ULL<<59);
-            }
-        }
+// Toggle the squares in 'b' for piece 'p' in its bitboard and the occupancies
+static inline void toggle_piece(Position &pos, Piece p, Bitboard b) {
+    pos.pieces[p] ^= b;
+    pos.occupancies[p / 6] ^= b;
+}
+
+static inline void put_piece(Position &pos, Piece p, int sq) {
+    toggle_piece(pos, p, 1ULL << sq);
+    pos.board[sq] = p;
+    pos.key ^= zobrist.piece_square[p][sq];
+}
+
+static inline void remove_piece(Position &pos, Piece p, int sq) {
+    toggle_piece(pos, p, 1ULL << sq);
+    pos.board[sq] = NO_PIECE;
+    pos.key ^= zobrist.piece_square[p][sq];
+}
+
+static inline void move_piece(Position &pos, Piece p, int from, int to) {
+    toggle_piece(pos, p, (1ULL << from) | (1ULL << to));
+    pos.board[from] = NO_PIECE;
+    pos.board[to] = p;
+    pos.key ^= zobrist.piece_square[p][from] ^ zobrist.piece_square[p][to];
+}
+
+
+// Rook source and destination for a castling king move to 'king_to'
+static inline void castling_rook_squares(int king_to, int &rook_from, int &rook_to) {
+    switch (king_to) {
+        case 6:  rook_from = 7;  rook_to = 5;  break;
+        case 2:  rook_from = 0;  rook_to = 3;  break;
+        case 62: rook_from = 63; rook_to = 61; break;
+        default: rook_from = 56; rook_to = 59; break;
     }
+}
+
+void make_move(Position &pos, Move m, UndoInfo &undo) {
+    Color side = pos.side_to_move;
+    int from = m.from(), to = m.to();
+    Piece piece = pos.board[from];
+
+    undo.captured = NO_PIECE;
+    undo.en_passant = pos.en_passant;
+    undo.halfmove_clock = pos.halfmove_clock;
+    undo.castle_rights = pos.castle_rights;
+    undo.key = pos.key;
+    undo.checkers = pos.checkers;
+    undo.pinned = pos.pinned;
+
+    pos.halfmove_clock++;
+    pos.key ^= en_passant_key(pos.en_passant) ^ zobrist.side;
 
     // Handle captures
-    if (m.capture) {
-        if (m.en_passant) {
-            int cap_sq = side == WHITE ? m.to-8 : m.to+8;
-            int cap_piece = side == WHITE ? BP : WP;
-            pos.pieces[cap_piece] &= ~(1ULL<<cap_sq);
-        } else {
-            for (int i = opp*6; i < opp*6+6; ++i) {
-                if (pos.pieces[i] & (1ULL<<m.to)) {
-                    pos.pieces[i] &= ~(1ULL<<m.to);
-                    break;
-                }
-            }
-        }
+    if (m.is_capture()) {
+        int cap_sq = m.is_en_passant() ? (side == WHITE ? to - 8 : to + 8) : to;
+        undo.captured = pos.board[cap_sq];
+        remove_piece(pos, undo.captured, cap_sq);
+        pos.halfmove_clock = 0;
     }
+    if (piece == WP || piece == BP) pos.halfmove_clock = 0;
 
     // Handle promotion or normal move
-    if (m.promotion != NO_PIECE) {
-        pos.pieces[m.promotion] |= (1ULL<<m.to);
+    if (m.is_promotion()) {
+        remove_piece(pos, piece, from);
+        put_piece(pos, make_piece(side, m.promotion_type()), to);
     } else {
-        pos.pieces[piece_index] |= (1ULL<<m.to);
+        move_piece(pos, piece, from, to);
     }
 
-    // Update occupancies
-    pos.occupancies[WHITE] = 0;
-    pos.occupancies[BLACK] = 0;
-    for (int i = 0; i < 6; ++i) pos.occupancies[WHITE] |= pos.pieces[i];
-    for (int i = 6; i < 12; ++i) pos.occupancies[BLACK] |= pos.pieces[i];
-    pos.occupancies[2] = pos.occupancies[WHITE] | pos.occupancies[BLACK];
-
-    // Update castling rights
-    if (piece_index == WK) { pos.castle_rights[0] = pos.castle_rights[1] = false; }
-    else if (piece_index == BK) { pos.castle_rights[2] = pos.castle_rights[3] = false; }
-    if (piece_index == WR) {
-        if (m.from == 0) pos.castle_rights[1] = false;
-        else if (m.from == 7) pos.castle_rights[0] = false;
-    } else if (piece_index == BR) {
-        if (m.from == 56) pos.castle_rights[3] = false;
-        else if (m.from == 63) pos.castle_rights[2] = false;
-    }
-    if (m.capture && !m.en_passant) {
-        if (m.to == 0) pos.castle_rights[1] = false;
-        else if (m.to == 7) pos.castle_rights[0] = false;
-        else if (m.to == 56) pos.castle_rights[3] = false;
-        else if (m.to == 63) pos.castle_rights[2] = false;
+    // Handle castling rook move
+    if (m.is_castling()) {
+        int rook_from, rook_to;
+        castling_rook_squares(to, rook_from, rook_to);
+        move_piece(pos, make_piece(side, ROOK), rook_from, rook_to);
     }
 
-    // Update en passant square
-    if ((piece_index == WP && m.to - m.from == 16) ||
-        (piece_index == BP && m.from - m.to == 16)) {
-        pos.en_passant = (m.from + m.to) / 2;
-    } else {
-        pos.en_passant = -1;
+    // Castling rights lost when a move touches a king or rook home square
+    uint8_t rights = pos.castle_rights & castle_masks.keep[from] & castle_masks.keep[to];
+    if (rights != pos.castle_rights) {
+        pos.key ^= castle_keys.key[pos.castle_rights] ^ castle_keys.key[rights];
+        pos.castle_rights = rights;
     }
 
+    // Update en passant square, set only when an enemy pawn can capture
+    pos.en_passant = -1;
+    if (m.is_double_push() &&
+        (pawn_attacks[side][(from + to) / 2] & pos.pieces[make_piece(Color(side ^ 1), PAWN)]))
+        pos.en_passant = int8_t((from + to) / 2);
+
     // Switch side to move
-    pos.side_to_move = opp;
+    if (side == BLACK) pos.fullmove_clock++;
+    pos.side_to_move = Color(side ^ 1);
+    pos.key ^= en_passant_key(pos.en_passant);
+    if (side == WHITE) refresh_check_info<BLACK>(pos);
+    else refresh_check_info<WHITE>(pos);
 }
 
-// Set position from FEN string; returns false on invalid FEN
-bool set_fen(Position &pos, const std::string &fen) {
-    std::istringstream iss(fen);
-    std::string piece_placement, side_str, castling_str, ep_str;
-    int halfmove, fullmove;
-    if (!(iss >> piece_placement >> side_str >> castling_str >> ep_str >> halfmove >> fullmove))
-        return false;
-    // Clear piece bitboards
-    std::memset(pos.pieces, 0, sizeof(pos.pieces));
-    // Parse piece placement
-    std::vector<std::string> ranks;
-    std::istringstream riss(piece_placement);
-    std::string rank_str;
-    while (std::getline(riss, rank_str, '/')) ranks.push_back(rank_str);
-    if (ranks.size() != 8) return false;
-    for (int i = 0; i < 8; ++i) {
-        const std::string &rstr = ranks[i];
-        int file = 0;
-        int rank = 7 - i;
-        for (char c : rstr) {
-            if (std::isdigit(c)) {
-                file += c - '0';
-            } else {
-                if (file < 0 || file > 7) return false;
-                int sq = rank * 8 + file;
-                Piece p = NO_PIECE;
-                switch (c) {
-                    case 'P': p = WP; break;
-                    case 'N': p = WN; break;
-                    case 'B': p = WB; break;
-                    case 'R': p = WR; break;
-                    case 'Q': p = WQ; break;
-                    case 'K': p = WK; break;
-                    case 'p': p = BP; break;
-                    case 'n': p = BN; break;
-                    case 'b': p = BB; break;
-                    case 'r': p = BR; break;
-                    case 'q': p = BQ; break;
-                    case 'k': p = BK; break;
-                    default: return false;
-                }
-                pos.pieces[p] |= (1ULL << sq);
-                file++;
-            }
-        }
-        if (file != 8) return false;
+void make_move(Position &pos, Move m) {
+    UndoInfo undo;
+    make_move(pos, m, undo);
+}
+
+void unmake_move(Position &pos, Move m, const UndoInfo &undo) {
+    Color side = Color(pos.side_to_move ^ 1);
+    int from = m.from(), to = m.to();
+    pos.side_to_move = side;
+    if (side == BLACK) pos.fullmove_clock--;
+
+    if (m.is_castling()) {
+        int rook_from, rook_to;
+        castling_rook_squares(to, rook_from, rook_to);
+        move_piece(pos, make_piece(side, ROOK), rook_to, rook_from);
     }
-    // Update occupancies
-    pos.occupancies[WHITE] = pos.occupancies[BLACK] = 0;
-    for (int p = WP; p <= WK; ++p) pos.occupancies[WHITE] |= pos.pieces[p];
-    for (int p = BP; p <= BK; ++p) pos.occupancies[BLACK] |= pos.pieces[p];
-    pos.occupancies[2] = pos.occupancies[WHITE] | pos.occupancies[BLACK];
-    // Side to move
-    if (side_str == "w") pos.side_to_move = WHITE;
-    else if (side_str == "b") pos.side_to_move = BLACK;
-    else return false;
-    // Castling rights
-    pos.castle_rights = {false, false, false, false};
-    if (castling_str.find('K') != std::string::npos) pos.castle_rights[0] = true;
-    if (castling_str.find('Q') != std::string::npos) pos.castle_rights[1] = true;
-    if (castling_str.find('k') != std::string::npos) pos.castle_rights[2] = true;
-    if (castling_str.find('q') != std::string::npos) pos.castle_rights[3] = true;
-    // En passant target
-    if (ep_str == "-") {
-        pos.en_passant = -1;
+
+    if (m.is_promotion()) {
+        remove_piece(pos, pos.board[to], to);
+        put_piece(pos, make_piece(side, PAWN), from);
     } else {
-        if (ep_str.size() != 2) return false;
-        char f = ep_str[0]; char r = ep_str[1];
-        if (f < 'a' || f > 'h' || r < '1' || r > '8') return false;
-        int file = f - 'a';
-        int rank = r - '1';
-        pos.en_passant = rank * 8 + file;
+        move_piece(pos, pos.board[to], to, from);
     }
-    // Halfmove and fullmove clocks
-    pos.halfmove_clock = halfmove;
-    pos.fullmove_clock = fullmove;
-    return true;
+
+    if (undo.captured != NO_PIECE) {
+        int cap_sq = m.is_en_passant() ? (side == WHITE ? to - 8 : to + 8) : to;
+        put_piece(pos, undo.captured, cap_sq);
+    }
+
+    pos.en_passant = undo.en_passant;
+    pos.halfmove_clock = undo.halfmove_clock;
+    pos.castle_rights = undo.castle_rights;
+    pos.key = undo.key;
+    pos.checkers = undo.checkers;
+    pos.pinned = undo.pinned;
+}
+
+bool set_fen(Position &pos, const std::string &fen) {
+    return parse_fen(fen, pos) == FenError::None;
 }
 
-// Get FEN string from position
 std::string get_fen(const Position &pos) {
-    std::ostringstream oss;
-    for (int rank = 7; rank >= 0; --rank) {
-        int empty = 0;
-        for (int file = 0; file < 8; ++file) {
-            int sq = rank * 8 + file;
-            char pc = '.';
-            for (int p = WP; p <= BK; ++p) {
-                if (pos.pieces[p] & (1ULL << sq)) {
-                    static const char map[] = {'P','N','B','R','Q','K','p','n','b','r','q','k'};
-                    pc = map[p];
-                    break;
-                }
-            }
-            if (pc == '.') {
-                empty++;
-            } else {
-                if (empty) { oss << empty; empty = 0; }
-                oss << pc;
-            }
-        }
-        if (empty) oss << empty;
-        if (rank > 0) oss << '/';
-    }
-    // Side to move
-    oss << ' ' << (pos.side_to_move == WHITE ? 'w' : 'b');
-    // Castling rights
-    oss << ' ';
-    std::string cr;
-    if (pos.castle_rights[0]) cr += 'K';
-    if (pos.castle_rights[1]) cr += 'Q';
-    if (pos.castle_rights[2]) cr += 'k';
-    if (pos.castle_rights[3]) cr += 'q';
-    oss << (cr.empty() ? "-" : cr);
-    // En passant target
-    oss << ' ';
-    if (pos.en_passant < 0) {
-        oss << '-';
-    } else {
-        int file = pos.en_passant % 8;
-        int rank = pos.en_passant / 8;
-        oss << char('a' + file) << char('1' + rank);
-    }
-    // Halfmove and fullmove clocks
-    oss << ' ' << pos.halfmove_clock << ' ' << pos.fullmove_clock;
-    return oss.str();
+    char buf[FEN_BUFFER_SIZE];
+    return std::string(buf, write_fen(pos, buf, sizeof(buf)));
 }
 
-// Get ASCII diagram of the position
 std::string position_to_string(const Position &pos) {
-    std::ostringstream oss;
+    static constexpr char piece_chars[] = "PNBRQKpnbrqk.";
+    std::string out;
     for (int rank = 7; rank >= 0; --rank) {
-        oss << rank + 1 << " ";
+        out += char('1' + rank);
         for (int file = 0; file < 8; ++file) {
-            int sq = rank * 8 + file;
-            char pc = '.';
-            for (int p = WP; p <= BK; ++p) {
-                if (pos.pieces[p] & (1ULL << sq)) {
-                    static const char map[] = {'P','N','B','R','Q','K','p','n','b','r','q','k'};
-                    pc = map[p];
-                    break;
-                }
-            }
-            oss << pc;
-            if (file < 7) oss << ' ';
+            out += ' ';
+            out += piece_chars[pos.board[rank * 8 + file]];
         }
-        oss << '\n';
+        out += '\n';
     }
-    oss << "  a b c d e f g h\n";
-    return oss.str();
+    out += "  a b c d e f g h\n";
+    return out;
 }
 
 } // namespace chess
\ No newline at end of file
@@ -2,19 +2,51 @@
  #define CHESS_POSITION_H
 
 #include "types.h"
-#include <array>
 #include <string>
 
 namespace chess {
 
-struct Position {
+// Castling rights, one bit each in Position::castle_rights
+enum CastlingRight : uint8_t {
+    WHITE_OO = 1, WHITE_OOO = 2, BLACK_OO = 4, BLACK_OOO = 8,
+    ALL_CASTLING = 15
+};
+
+// Four cache lines: the bitboards and cached check information, then the
+// key and game state, then the mailbox on a line of its own.
+struct alignas(64) Position {
     Bitboard pieces[12];
-    Bitboard occupancies[3];
+    // Per color; occupied() is their union
+    Bitboard occupancies[2];
+    // Derived from the placement and kept current by make_move, unmake_move
+    // and the loaders: enemy pieces giving check to the side to move, and
+    // its pieces absolutely pinned to its own king
+    Bitboard checkers;
+    Bitboard pinned;
+    // Zobrist hash of pieces, side, castle rights and en passant square
+    uint64_t key;
     Color side_to_move;
-    int en_passant;
-    std::array<bool, 4> castle_rights;
-    int halfmove_clock;
-    int fullmove_clock;
+    int8_t en_passant;       // -1 when there is none
+    uint8_t castle_rights;   // CastlingRight bits; bit i is right i in KQkq order
+    uint16_t halfmove_clock;
+    uint16_t fullmove_clock;
+    // Mailbox kept in sync with the bitboards; NO_PIECE on empty squares
+    alignas(64) Piece board[64];
+
+    Bitboard occupied() const { return occupancies[WHITE] | occupancies[BLACK]; }
+    bool has_castle_right(int i) const { return castle_rights & (1 << i); }
+};
+static_assert(sizeof(Position) == 256, "Position should span exactly four cache lines");
+
+// State needed to take back a move with unmake_move
+struct UndoInfo {
+    uint64_t key;
+    Bitboard checkers;
+    Bitboard pinned;
+    Piece captured;
+    int8_t en_passant;
+    uint8_t castle_rights;
+    uint16_t halfmove_clock;
 };
 
 // Initialize starting position
@@ -25,9 +57,28 @@ bool set_fen(Position &pos, const std::string &fen);
 std::string get_fen(const Position &pos);
 // Get ASCII diagram of the position
 std::string position_to_string(const Position &pos);
+// Pieces of both colors attacking 'sq' when the board holds 'occ'
+Bitboard attackers_to(const Position &pos, int sq, Bitboard occ);
+// Recompute checkers and pinned from the placement and side to move
+void update_check_info(Position &pos);
+// Pieces of color 'c' pinned to their king: the cached set for the side
+// to move, computed on demand for the other side
+Bitboard pinned_pieces(const Position &pos, Color c);
+// Clear the en passant square unless a pawn of the side to move attacks
+// it, so that, as in the repetition rule, positions differ only when the
+// capture is possible. make_move does this itself; loaders call it before
+// compute_key.
+void drop_dead_en_passant(Position &pos);
+// Compute the Zobrist key of a position from scratch; needs the mailbox
+// and occupancies to be current
+uint64_t compute_key(const Position &pos);
 
 // Make move and update position state
-void make_move(Position &pos, const Move &m);
+void make_move(Position &pos, Move m);
+// Make move, recording what unmake_move needs in 'undo'
+void make_move(Position &pos, Move m, UndoInfo &undo);
+// Take back a move made with make_move(pos, m, undo)
+void unmake_move(Position &pos, Move m, const UndoInfo &undo);
 
 } // namespace chess
 
@@ -0,0 +1,326 @@
+ #include "search.h"
+ #include "bitboard.h"
+ #include "evaluate.h"
+ #include "fen.h"
+ #include "movegen.h"
+ #include "movepick.h"
+ #include <algorithm>
+ #include <chrono>
+ #include <cstring>
+ #include <iomanip>
+ #include <ostream>
+ #include <string>
+
+namespace chess {
+
+enum Bound : uint8_t { BOUND_NONE, BOUND_UPPER, BOUND_LOWER, BOUND_EXACT };
+
+struct TTEntry {
+    uint64_t key;
+    Move move;
+    int16_t score;
+    int8_t depth;
+    uint8_t bound;
+    uint32_t padding;
+};
+
+// One cache line of entries sharing a table index, as in the perft table
+struct alignas(64) TTBucket {
+    TTEntry entries[4];
+};
+
+// Mate scores are stored relative to the node so they stay valid when the
+// same position is reached at another ply
+static inline int score_to_tt(int score, int ply) {
+    return score >= MATE_BOUND ? score + ply : score <= -MATE_BOUND ? score - ply : score;
+}
+
+static inline int score_from_tt(int score, int ply) {
+    return score >= MATE_BOUND ? score - ply : score <= -MATE_BOUND ? score + ply : score;
+}
+
+// History scores stay below this; reaching it halves the whole table, so
+// the relative order survives and an int can never overflow
+static constexpr int history_limit = 1 << 20;
+
+static inline void age_history(int (&history)[12][64]) {
+    for (auto &row : history)
+        for (int &h : row) h /= 2;
+}
+
+static int64_t now_ms() {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+Search::Search(size_t table_mb) {
+    resize(table_mb);
+}
+
+Search::~Search() = default;
+
+void Search::resize(size_t table_mb) {
+    size_t count = 1;
+    while (count * 2 * sizeof(TTBucket) <= table_mb * 1024 * 1024) count *= 2;
+    table_.reset(new TTBucket[count]);
+    table_mask_ = count - 1;
+    clear();
+}
+
+void Search::clear() {
+    std::memset(static_cast<void *>(table_.get()), 0, (table_mask_ + 1) * sizeof(TTBucket));
+    std::memset(killers_, 0, sizeof(killers_));
+    std::memset(history_, 0, sizeof(history_));
+}
+
+static inline TTEntry *probe_tt(TTBucket *table, uint64_t mask, uint64_t key) {
+    for (TTEntry &e : table[key & mask].entries)
+        if (e.key == key && e.bound != BOUND_NONE) return &e;
+    return nullptr;
+}
+
+// Overwrite the entry for this key if present, else the shallowest one
+static inline void store_tt(TTBucket *table, uint64_t mask, uint64_t key, Move move,
+    int score, int depth, Bound bound) {
+    TTBucket &b = table[key & mask];
+    TTEntry *victim = &b.entries[0];
+    for (TTEntry &e : b.entries) {
+        if (e.key == key) {
+            victim = &e;
+            break;
+        }
+        if (e.depth < victim->depth) victim = &e;
+    }
+    // Keep the old best move when this search found none
+    if (move == Move(0, 0) && victim->key == key) move = victim->move;
+    *victim = {key, move, int16_t(score), int8_t(depth), uint8_t(bound), 0};
+}
+
+bool Search::should_stop() {
+    if (limits_.stop && limits_.stop->load(std::memory_order_relaxed)) return true;
+    if (limits_.nodes && nodes_ >= limits_.nodes) return true;
+    return limits_.movetime_ms && now_ms() - start_ms_ >= limits_.movetime_ms;
+}
+
+int Search::quiescence(Position &pos, int ply, int alpha, int beta) {
+    pv_length_[ply] = ply;
+    if ((nodes_ & 1023) == 0 && should_stop()) stop_.store(true, std::memory_order_relaxed);
+    if (stop_.load(std::memory_order_relaxed)) return 0;
+    nodes_++;
+    seldepth_ = std::max(seldepth_, ply);
+    if (ply >= MAX_PLY - 1) return evaluate(pos);
+
+    // Standing pat is not an option in check; every evasion is searched
+    bool check = in_check(pos);
+    int best = -MATE_SCORE + ply;
+    if (!check) {
+        best = evaluate(pos);
+        if (best >= beta) return best;
+        alpha = std::max(alpha, best);
+    }
+
+    // Captures and promotions, or every evasion in check
+    MovePicker picker(pos);
+    UndoInfo undo;
+    for (Move m; (m = picker.next()) != Move(0, 0);) {
+        if (!check && m.is_promotion() && !m.is_capture() && m.promotion_type() != QUEEN)
+            continue;
+        make_move(pos, m, undo);
+        int score = -quiescence(pos, ply + 1, -beta, -alpha);
+        unmake_move(pos, m, undo);
+        if (stop_.load(std::memory_order_relaxed)) return 0;
+        if (score > best) {
+            best = score;
+            if (score > alpha) {
+                alpha = score;
+                if (score >= beta) break;
+            }
+        }
+    }
+    return best;
+}
+
+int Search::negamax(Position &pos, int depth, int ply, int alpha, int beta) {
+    pv_length_[ply] = ply;
+    if (ply > 0) {
+        if ((nodes_ & 1023) == 0 && should_stop()) stop_.store(true, std::memory_order_relaxed);
+        if (stop_.load(std::memory_order_relaxed)) return 0;
+        // Fifty-move rule and repetitions along the search path
+        if (pos.halfmove_clock >= 100) return 0;
+        int here = root_ + ply;
+        for (int i = here - 2; i >= 0 && i >= here - pos.halfmove_clock; i -= 2)
+            if (keys_[i] == pos.key) return 0;
+        // No line from here can beat a mate already found closer to the root
+        alpha = std::max(alpha, -MATE_SCORE + ply);
+        beta = std::min(beta, MATE_SCORE - ply - 1);
+        if (alpha >= beta) return alpha;
+    }
+    if (ply >= MAX_PLY - 1) return evaluate(pos);
+    keys_[root_ + ply] = pos.key;
+
+    bool check = in_check(pos);
+    if (check) depth++;
+    if (depth <= 0) return quiescence(pos, ply, alpha, beta);
+    nodes_++;
+
+    bool pv_node = beta - alpha > 1;
+    Move tt_move = Move(0, 0);
+    if (TTEntry *e = probe_tt(table_.get(), table_mask_, pos.key)) {
+        tt_move = e->move;
+        int score = score_from_tt(e->score, ply);
+        if (!pv_node && e->depth >= depth &&
+            (e->bound == BOUND_EXACT || (e->bound == BOUND_LOWER && score >= beta) ||
+             (e->bound == BOUND_UPPER && score <= alpha)))
+            return score;
+    }
+
+    MovePicker picker(pos, tt_move, killers_[ply], history_);
+    int alpha_orig = alpha;
+    int best = -MATE_SCORE;
+    Move best_move = Move(0, 0);
+    int played = 0;
+    UndoInfo undo;
+    for (Move m; (m = picker.next()) != Move(0, 0);) {
+        Piece moved = pos.board[m.from()];
+        make_move(pos, m, undo);
+        int score;
+        if (played++ == 0) {
+            score = -negamax(pos, depth - 1, ply + 1, -beta, -alpha);
+        } else {
+            // Later moves only need to prove they are no better than alpha
+            score = -negamax(pos, depth - 1, ply + 1, -alpha - 1, -alpha);
+            if (score > alpha && score < beta)
+                score = -negamax(pos, depth - 1, ply + 1, -beta, -alpha);
+        }
+        unmake_move(pos, m, undo);
+        if (stop_.load(std::memory_order_relaxed)) return 0;
+
+        if (score > best) {
+            best = score;
+            best_move = m;
+            if (score > alpha) {
+                alpha = score;
+                pv_[ply][ply] = m;
+                for (int j = ply + 1; j < pv_length_[ply + 1]; ++j) pv_[ply][j] = pv_[ply + 1][j];
+                pv_length_[ply] = std::max(pv_length_[ply + 1], ply + 1);
+                if (score >= beta) {
+                    if (!m.is_capture() && !m.is_promotion()) {
+                        if (killers_[ply][0] != m) {
+                            killers_[ply][1] = killers_[ply][0];
+                            killers_[ply][0] = m;
+                        }
+                        int &h = history_[moved][m.to()];
+                        h += depth * depth;
+                        if (h >= history_limit) age_history(history_);
+                    }
+                    break;
+                }
+            }
+        }
+    }
+
+    if (played == 0) return check ? -MATE_SCORE + ply : 0;
+
+    Bound bound = best >= beta ? BOUND_LOWER : best > alpha_orig ? BOUND_EXACT : BOUND_UPPER;
+    store_tt(table_.get(), table_mask_, pos.key, best_move, score_to_tt(best, ply), depth, bound);
+    return best;
+}
+
+SearchResult Search::run(const Position &pos, const SearchLimits &limits,
+    const std::function<void(const SearchResult &)> &on_iteration,
+    const std::vector<uint64_t> &history) {
+    stop_.store(false, std::memory_order_relaxed);
+    // Only positions since the last capture or pawn move can repeat, and
+    // the fifty-move rule ends any line before it reaches further back
+    size_t kept = std::min({history.size(), size_t(pos.halfmove_clock), size_t(game_keys)});
+    std::copy(history.end() - kept, history.end(), keys_);
+    root_ = int(kept);
+    limits_ = limits;
+    start_ms_ = now_ms();
+    nodes_ = 0;
+    std::memset(killers_, 0, sizeof(killers_));
+    // Older searches count for less
+    age_history(history_);
+    auto start = std::chrono::steady_clock::now();
+
+    SearchResult result;
+    Position root = pos;
+    MoveList legal;
+    generate_legal_moves(root, legal);
+    if (legal.size() == 0) {
+        result.score = in_check(root) ? -MATE_SCORE : 0;
+        return result;
+    }
+    // A move to fall back on if even the first iteration is cut short
+    result.best = legal[0];
+
+    int max_depth = limits.depth > 0 ? std::min(limits.depth, MAX_PLY - 1) : MAX_PLY - 1;
+    for (int depth = 1; depth <= max_depth; ++depth) {
+        seldepth_ = 0;
+        int score = negamax(root, depth, 0, -MATE_SCORE, MATE_SCORE);
+        if (stop_.load(std::memory_order_relaxed)) break;
+
+        result.best = pv_[0][0];
+        result.score = score;
+        result.depth = depth;
+        result.seldepth = std::max(seldepth_, depth);
+        result.nodes = nodes_;
+        result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        result.pv.assign(pv_[0], pv_[0] + pv_length_[0]);
+        if (on_iteration) on_iteration(result);
+
+        // A mate within the searched depth will not change; an unbounded
+        // search still waits for stop()
+        bool bounded = limits.depth || limits.movetime_ms || limits.nodes;
+        if (bounded && std::abs(score) >= MATE_BOUND && MATE_SCORE - std::abs(score) <= depth)
+            break;
+        // The next iteration takes longer than all before it together
+        if (limits.movetime_ms && (now_ms() - start_ms_) * 2 > limits.movetime_ms) break;
+    }
+    result.nodes = nodes_;
+    result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return result;
+}
+
+std::string score_to_string(int score) {
+    if (std::abs(score) < MATE_BOUND) return "cp " + std::to_string(score);
+    int moves = (MATE_SCORE - std::abs(score) + 1) / 2;
+    return "mate " + std::to_string(score > 0 ? moves : -moves);
+}
+
+// Openings, middlegames and endgames with tactics for the search bench
+static const char *const search_bench_fens[] = {
+    "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",
+    "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+    "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1",
+    "r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1",
+    "rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8",
+    "r4rk1/1pp1qppp/p1np1n2/2b1p1B1/2B1P1b1/P1NP1N2/1PP1QPPP/R4RK1 w - - 0 10",
+    "2r2rk1/pp1bqppp/2n1pn2/3p4/2PP4/P1NBPN2/1P3PPP/2RQ1RK1 b - - 2 12",
+    "r1b2rk1/2q1bppp/p2p1n2/np2p3/3PP3/5N1P/PPBN1PP1/R1BQR1K1 b - - 0 13",
+    "8/5k2/3p4/1p1Pp2p/pP2Pp1P/P4P1K/8/8 b - - 9 50",
+    "6k1/5ppp/8/8/8/8/5PPP/3R2K1 w - - 0 1",
+};
+
+uint64_t run_search_bench(int depth, std::ostream &out) {
+    Search search(16);
+    SearchLimits limits;
+    limits.depth = depth;
+    uint64_t nodes = 0;
+    double seconds = 0;
+    for (const char *fen : search_bench_fens) {
+        Position pos;
+        parse_fen(fen, pos);
+        search.clear();
+        SearchResult r = search.run(pos, limits);
+        nodes += r.nodes;
+        seconds += r.seconds;
+        out << std::setw(10) << r.nodes << "  " << move_to_uci(r.best) << "  "
+            << score_to_string(r.score) << "  " << fen << "\n";
+    }
+    out << "Search bench: " << nodes << " nodes in " << std::fixed << std::setprecision(3)
+        << seconds << " s (" << uint64_t(seconds > 0 ? nodes / seconds : 0) << " nps)\n";
+    return nodes;
+}
+
+} // namespace chess
@@ -0,0 +1,102 @@
+ #ifndef CHESS_SEARCH_H
+ #define CHESS_SEARCH_H
+
+ #include "position.h"
+ #include <atomic>
+ #include <cstddef>
+ #include <cstdint>
+ #include <functional>
+ #include <iosfwd>
+ #include <memory>
+ #include <string>
+ #include <vector>
+
+namespace chess {
+
+constexpr int MAX_PLY = 128;
+constexpr int MATE_SCORE = 32000;
+// Scores beyond this are mates; MATE_SCORE - n means mate in n plies
+constexpr int MATE_BOUND = MATE_SCORE - MAX_PLY;
+
+// When to stop; zero fields are unlimited. With no limit at all the
+// search runs until stop() is called or MAX_PLY is reached.
+struct SearchLimits {
+    int depth = 0;
+    int64_t movetime_ms = 0;
+    uint64_t nodes = 0;
+    // Ends the search once set, like stop(), but owned by the caller so a
+    // request made before run() starts is not lost
+    const std::atomic<bool> *stop = nullptr;
+};
+
+// Result of the last completed iteration
+struct SearchResult {
+    Move best = Move(0, 0);
+    int score = 0;
+    int depth = 0;
+    int seldepth = 0;
+    uint64_t nodes = 0;
+    double seconds = 0;
+    std::vector<Move> pv;
+};
+
+struct TTBucket;
+
+// Negamax alpha-beta with iterative deepening, principal variation search,
+// quiescence, a transposition table, and staged move ordering (see
+// MovePicker). The table and history persist across calls to run(); the
+// history is halved at the start of each.
+class Search {
+public:
+    explicit Search(size_t table_mb = 16);
+    ~Search();
+
+    // Search 'pos' within 'limits'. 'on_iteration' is called after every
+    // completed depth. 'history' holds the keys of the game positions
+    // before 'pos', oldest first (see Game::recent_keys); a line that
+    // repeats one of them, or a position earlier on its own path, scores
+    // as a draw.
+    SearchResult run(const Position &pos, const SearchLimits &limits,
+        const std::function<void(const SearchResult &)> &on_iteration = {},
+        const std::vector<uint64_t> &history = {});
+
+    // Ask a running search to return; safe to call from another thread
+    void stop() { stop_.store(true, std::memory_order_relaxed); }
+    // Forget the table, killers and history
+    void clear();
+    void resize(size_t table_mb);
+
+private:
+    int negamax(Position &pos, int depth, int ply, int alpha, int beta);
+    int quiescence(Position &pos, int ply, int alpha, int beta);
+    bool should_stop();
+
+    std::unique_ptr<TTBucket[]> table_;
+    uint64_t table_mask_ = 0;
+    Move killers_[MAX_PLY][2];
+    int history_[12][64];
+    Move pv_[MAX_PLY][MAX_PLY];
+    int pv_length_[MAX_PLY];
+    // Keys along the search path, after up to game_keys from the game
+    static constexpr int game_keys = 100;
+    uint64_t keys_[game_keys + MAX_PLY];
+    int root_ = 0;  // index of the root's key
+
+    std::atomic<bool> stop_{false};
+    SearchLimits limits_;
+    int64_t start_ms_ = 0;
+    uint64_t nodes_ = 0;
+    int seldepth_ = 0;
+};
+
+// "cp 35" or "mate -3", as UCI prints scores
+std::string score_to_string(int score);
+
+// Search a fixed set of positions to 'depth' with a fresh table and
+// report the total node count and nodes/sec; the count is deterministic,
+// so it doubles as a signature of search behavior.
+uint64_t run_search_bench(int depth, std::ostream &out);
+
+} // namespace chess
+
+#endif // CHESS_SEARCH_H
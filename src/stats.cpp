@@ -0,0 +1,90 @@
+ #include "stats.h"
+ #include <chrono>
+ #include <iomanip>
+ #include <memory>
+ #include <mutex>
+ #include <ostream>
+ #include <vector>
+ #if defined(__x86_64__) || defined(__i386__)
+ #include <x86intrin.h>
+ #endif
+
+namespace chess {
+namespace stats {
+
+// Blocks are never freed, so a worker's counts survive its thread
+static std::mutex registry_lock;
+static std::vector<std::unique_ptr<ThreadCounters>> registry;
+
+ThreadCounters *register_thread() {
+    std::lock_guard<std::mutex> guard(registry_lock);
+    registry.push_back(std::make_unique<ThreadCounters>());
+    return registry.back().get();
+}
+
+void reset() {
+    std::lock_guard<std::mutex> guard(registry_lock);
+    for (auto &c : registry) *c = ThreadCounters();
+}
+
+uint64_t read_cycles() {
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+}
+
+static const char *const counter_names[CounterCount] = {
+    "movegen calls", "moves generated", "count calls", "moves counted",
+    "king targets rejected", "en passant rejected", "castles rejected",
+    "attack checks (legality)", "attack checks (castling)", "position copies",
+    "moves made", "leaf nodes", "  captures", "  en passant", "  castles",
+    "  promotions", "  checks", "  checkmates",
+};
+
+static const char *const timer_names[TimerCount] = {
+    "legal masks", "king moves", "pawn moves", "piece moves", "castling",
+};
+
+void report(std::ostream &out) {
+#if defined(ENABLE_STATS)
+    ThreadCounters total;
+    size_t threads;
+    {
+        std::lock_guard<std::mutex> guard(registry_lock);
+        threads = registry.size();
+        for (auto &c : registry) {
+            for (int i = 0; i < CounterCount; ++i) total.counts[i] += c->counts[i];
+            for (int i = 0; i < TimerCount; ++i) {
+                total.cycles[i] += c->cycles[i];
+                total.calls[i] += c->calls[i];
+            }
+        }
+    }
+    out << "Instrumentation (" << threads << " threads)\n";
+    for (int i = 0; i < CounterCount; ++i)
+        out << "  " << std::left << std::setw(28) << counter_names[i] << std::right
+            << std::setw(16) << total.counts[i] << "\n";
+#if defined(ENABLE_STATS_TIMERS)
+    uint64_t all = 0;
+    for (int i = 0; i < TimerCount; ++i) all += total.cycles[i];
+    out << "Movegen phase timers (cycles)\n";
+    for (int i = 0; i < TimerCount; ++i) {
+        out << "  " << std::left << std::setw(28) << timer_names[i] << std::right
+            << std::setw(16) << total.cycles[i] << std::fixed << std::setprecision(1)
+            << std::setw(8) << (all ? 100.0 * total.cycles[i] / all : 0.0) << "%"
+            << std::setw(10) << (total.calls[i] ? double(total.cycles[i]) / total.calls[i] : 0.0)
+            << " /call\n";
+    }
+#endif
+#else
+    (void)out;
+    (void)counter_names;
+    (void)timer_names;
+#endif
+}
+
+} // namespace stats
+} // namespace chess
@@ -0,0 +1,101 @@
+ #ifndef CHESS_STATS_H
+ #define CHESS_STATS_H
+
+ #include <cstdint>
+ #include <iosfwd>
+
+// Hot-path instrumentation. Counters are compiled in with ENABLE_STATS and
+// cycle timers around movegen phases with ENABLE_STATS_TIMERS; otherwise
+// every STAT_* macro expands to nothing. Each thread bumps its own block
+// of counters, and stats::report sums them once the work is done.
+
+namespace chess {
+namespace stats {
+
+enum Counter {
+    MovegenCalls,          // generate_legal_moves
+    MovesGenerated,
+    CountCalls,            // count_legal_moves
+    MovesCounted,
+    KingTargetsRejected,   // king steps onto attacked squares
+    EnPassantRejected,     // ep captures refused by the check/pin test
+    CastlesRejected,       // rights held and path empty, but a square attacked
+    AttackChecksLegality,  // is_square_attacked for king moves
+    AttackChecksCastling,  // is_square_attacked for castling paths
+    PositionCopies,        // whole Position copies in perft
+    MovesMade,
+    LeafNodes,             // perft leaf moves classified below
+    LeafCaptures,
+    LeafEnPassant,
+    LeafCastles,
+    LeafPromotions,
+    LeafChecks,
+    LeafCheckmates,
+    CounterCount
+};
+
+enum Timer {
+    TimeLegalMasks,
+    TimeKingMoves,
+    TimePawnMoves,
+    TimePieceMoves,
+    TimeCastling,
+    TimerCount
+};
+
+struct ThreadCounters {
+    uint64_t counts[CounterCount] = {};
+    uint64_t cycles[TimerCount] = {};
+    uint64_t calls[TimerCount] = {};
+};
+
+// Allocate a counter block that lives until exit and is included in reports
+ThreadCounters *register_thread();
+
+// This thread's counters, registered on first use
+inline ThreadCounters &local() {
+    static thread_local ThreadCounters *counters = register_thread();
+    return *counters;
+}
+
+// Reset every thread's counters
+void reset();
+
+// Print the summed counters and timers; prints nothing when compiled out
+void report(std::ostream &out);
+
+uint64_t read_cycles();
+
+// Adds the cycles spent in its scope to one timer
+class ScopedTimer {
+public:
+    explicit ScopedTimer(Timer t) : timer_(t), start_(read_cycles()) {}
+    ~ScopedTimer() {
+        ThreadCounters &c = local();
+        c.cycles[timer_] += read_cycles() - start_;
+        c.calls[timer_]++;
+    }
+
+private:
+    Timer timer_;
+    uint64_t start_;
+};
+
+} // namespace stats
+} // namespace chess
+
+#if defined(ENABLE_STATS)
+ #define STAT_INC(c) (::chess::stats::local().counts[::chess::stats::c]++)
+ #define STAT_ADD(c, n) (::chess::stats::local().counts[::chess::stats::c] += (n))
+#else
+ #define STAT_INC(c) ((void)0)
+ #define STAT_ADD(c, n) ((void)sizeof(n))
+#endif
+
+#if defined(ENABLE_STATS_TIMERS)
+ #define STAT_TIMER(t) ::chess::stats::ScopedTimer stat_timer_##t(::chess::stats::t)
+#else
+ #define STAT_TIMER(t) ((void)0)
+#endif
+
+#endif // CHESS_STATS_H
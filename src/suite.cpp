@@ -0,0 +1,199 @@
+ #include "suite.h"
+ #include "corpus.h"
+ #include "fen.h"
+ #include "perft.h"
+ #include "thread_pool.h"
+ #include <algorithm>
+ #include <cctype>
+ #include <chrono>
+ #include <iomanip>
+ #include <istream>
+ #include <ostream>
+ #include <sstream>
+
+namespace chess {
+
+static std::string trim(const std::string &s) {
+    size_t first = s.find_first_not_of(" \t\r\n");
+    if (first == std::string::npos) return "";
+    size_t last = s.find_last_not_of(" \t\r\n");
+    return s.substr(first, last - first + 1);
+}
+
+bool parse_epd_line(const std::string &text, EpdEntry &entry) {
+    entry.fen.clear();
+    entry.expected.clear();
+    std::string body = trim(text);
+    if (body.empty() || body[0] == '#') return true;
+
+    std::vector<std::string> fields;
+    std::istringstream iss(body);
+    std::string field;
+    while (std::getline(iss, field, ';')) fields.push_back(trim(field));
+
+    // The FEN is kept as written; parse_fen accepts it with or without clocks
+    entry.fen = fields[0];
+    if (entry.fen.empty()) return false;
+
+    // Depth fields look like "D3 8902"; other EPD opcodes are ignored
+    for (size_t i = 1; i < fields.size(); ++i) {
+        const std::string &f = fields[i];
+        if (f.size() < 2 || f[0] != 'D' || !std::isdigit(static_cast<unsigned char>(f[1])))
+            continue;
+        std::istringstream fiss(f.substr(1));
+        int depth;
+        uint64_t count;
+        std::string rest;
+        if (!(fiss >> depth >> count) || (fiss >> rest) || depth < 1) return false;
+        entry.expected.emplace_back(depth, count);
+    }
+    std::sort(entry.expected.begin(), entry.expected.end());
+    return !entry.expected.empty();
+}
+
+// One (position, depth) pair; the unit of parallel work
+struct SuiteTask {
+    size_t entry;
+    int depth;
+    uint64_t expected;
+    uint64_t nodes = 0;
+    double seconds = 0;
+};
+
+bool run_epd_suite(std::istream &in, std::ostream &out, int threads, int max_depth) {
+    std::vector<EpdEntry> entries;
+    std::vector<Position> positions;
+    std::vector<std::string> errors; // parse problems, reported after the run
+    std::string text;
+    int line = 0;
+    while (std::getline(in, text)) {
+        ++line;
+        EpdEntry entry;
+        entry.line = line;
+        bool ok = parse_epd_line(text, entry);
+        if (ok && entry.fen.empty()) continue;
+        Position pos;
+        FenError err = ok ? parse_fen(entry.fen, pos) : FenError::None;
+        if (!ok || err != FenError::None) {
+            errors.push_back("line " + std::to_string(line) + ": invalid EPD record" +
+                             (ok ? std::string(" (") + fen_error_string(err) + ")" : "") +
+                             ": " + trim(text));
+            continue;
+        }
+        entries.push_back(entry);
+        positions.push_back(pos);
+    }
+
+    std::vector<SuiteTask> tasks;
+    for (size_t i = 0; i < entries.size(); ++i)
+        for (const auto &[depth, count] : entries[i].expected)
+            if (max_depth == 0 || depth <= max_depth) tasks.push_back({i, depth, count});
+    // Start the biggest trees first so no worker is left with one at the end
+    std::vector<size_t> order(tasks.size());
+    for (size_t i = 0; i < order.size(); ++i) order[i] = i;
+    std::stable_sort(order.begin(), order.end(),
+        [&](size_t a, size_t b) { return tasks[a].expected > tasks[b].expected; });
+
+    auto start = std::chrono::high_resolution_clock::now();
+    parallel_for(order.size(), threads, [&](size_t i, int) {
+        SuiteTask &t = tasks[order[i]];
+        auto t0 = std::chrono::high_resolution_clock::now();
+        t.nodes = perft(positions[t.entry], t.depth);
+        auto t1 = std::chrono::high_resolution_clock::now();
+        t.seconds = std::chrono::duration<double>(t1 - t0).count();
+    });
+    auto end = std::chrono::high_resolution_clock::now();
+    double wall = std::chrono::duration<double>(end - start).count();
+
+    // Tasks were created per entry in depth order, so report in file order
+    out << std::fixed;
+    size_t failed_positions = 0, failed_depths = 0;
+    uint64_t total_nodes = 0;
+    size_t next = 0;
+    for (size_t i = 0; i < entries.size(); ++i) {
+        out << "Position " << i + 1 << " (line " << entries[i].line << "): "
+            << entries[i].fen << "\n";
+        uint64_t nodes = 0;
+        double seconds = 0;
+        bool passed = true;
+        for (; next < tasks.size() && tasks[next].entry == i; ++next) {
+            const SuiteTask &t = tasks[next];
+            bool ok = t.nodes == t.expected;
+            out << "  D" << t.depth << (ok ? " PASS " : " FAIL ") << std::setw(12) << t.nodes;
+            if (!ok) out << " (expected " << t.expected << ")";
+            out << std::setprecision(3) << "  " << t.seconds << " s\n";
+            if (!ok) { passed = false; ++failed_depths; }
+            nodes += t.nodes;
+            seconds += t.seconds;
+        }
+        if (!passed) ++failed_positions;
+        total_nodes += nodes;
+        out << "  " << nodes << " nodes in " << std::setprecision(3) << seconds << " s ("
+            << std::setprecision(1) << (seconds > 0 ? nodes / seconds / 1e6 : 0.0) << " Mnps)\n";
+    }
+    for (const std::string &e : errors) out << e << "\n";
+
+    bool ok = failed_positions == 0 && errors.empty();
+    out << (ok ? "Suite passed: " : "Suite FAILED: ") << entries.size() - failed_positions
+        << "/" << entries.size() << " positions, " << tasks.size() - failed_depths << "/"
+        << tasks.size() << " depths";
+    if (!errors.empty()) out << ", " << errors.size() << " invalid records";
+    out << "\n" << total_nodes << " nodes in " << std::setprecision(3) << wall << " s on "
+        << std::max(threads, 1) << " threads (" << std::setprecision(1)
+        << (wall > 0 ? total_nodes / wall / 1e6 : 0.0) << " Mnps)\n";
+    return ok;
+}
+
+bool run_corpus_suite(const CorpusReader &corpus, std::ostream &out, int threads, int max_depth) {
+    bool checked = corpus.payload_kind() == CorpusPayload::PerftCount;
+    size_t n = corpus.size();
+    // Per-record results; each task writes only its own slot
+    std::vector<uint64_t> nodes(n, 0);
+    std::vector<char> status(n, 0); // 0 pass, 1 fail, 2 skipped, 3 corrupt
+
+    auto start = std::chrono::high_resolution_clock::now();
+    parallel_for(n, threads, [&](size_t i, int) {
+        Position pos;
+        if (!corpus.read(i, pos)) {
+            status[i] = 3;
+            return;
+        }
+        int depth = checked ? perft_payload_depth(corpus.payload(i)) : std::max(max_depth, 1);
+        if (depth == 0 || (max_depth && depth > max_depth)) {
+            status[i] = 2;
+            return;
+        }
+        nodes[i] = perft(pos, depth);
+        if (checked && nodes[i] != perft_payload_nodes(corpus.payload(i))) status[i] = 1;
+    });
+    auto end = std::chrono::high_resolution_clock::now();
+    double wall = std::chrono::duration<double>(end - start).count();
+
+    size_t failed = 0, skipped = 0;
+    uint64_t total = 0;
+    char fen[FEN_BUFFER_SIZE];
+    for (size_t i = 0; i < n; ++i) {
+        total += nodes[i];
+        if (status[i] == 2) ++skipped;
+        if (status[i] != 1 && status[i] != 3) continue;
+        ++failed;
+        out << "Record " << i << ": ";
+        Position pos;
+        if (status[i] == 3 || !corpus.read(i, pos)) {
+            out << "corrupt record\n";
+            continue;
+        }
+        write_fen(pos, fen, sizeof(fen));
+        out << fen << " D" << perft_payload_depth(corpus.payload(i)) << " FAIL " << nodes[i]
+            << " (expected " << perft_payload_nodes(corpus.payload(i)) << ")\n";
+    }
+    out << (failed ? "Corpus FAILED: " : "Corpus passed: ") << n - failed - skipped << "/" << n
+        << " records" << (checked ? " verified" : " run");
+    if (skipped) out << ", " << skipped << " skipped";
+    out << std::fixed << "\n" << total << " nodes in " << std::setprecision(3) << wall
+        << " s on " << std::max(threads, 1) << " threads (" << std::setprecision(1)
+        << (wall > 0 ? total / wall / 1e6 : 0.0) << " Mnps)\n";
+    return failed == 0;
+}
+
+} // namespace chess
@@ -0,0 +1,39 @@
+ #ifndef CHESS_SUITE_H
+ #define CHESS_SUITE_H
+
+ #include <cstdint>
+ #include <iosfwd>
+ #include <string>
+ #include <utility>
+ #include <vector>
+
+namespace chess {
+
+// One EPD record: a FEN followed by expected perft counts, e.g.
+// "<fen> ;D1 20 ;D2 400". The FEN may omit the move clocks.
+struct EpdEntry {
+    std::string fen;
+    std::vector<std::pair<int, uint64_t>> expected; // (depth, leaf count)
+    int line = 0;
+};
+
+// Parse one EPD line; returns false if it has no FEN or a malformed depth
+// field. Blank lines and '#' comments yield an entry with an empty FEN.
+bool parse_epd_line(const std::string &text, EpdEntry &entry);
+
+// Run every position in 'in' to each listed depth up to 'max_depth' (all
+// depths when 0) on 'threads' workers. Writes one line per position and
+// depth plus an aggregate summary to 'out'; returns true if all passed.
+bool run_epd_suite(std::istream &in, std::ostream &out, int threads, int max_depth);
+
+class CorpusReader;
+
+// Run perft on every record of a binary corpus. Records with a PerftCount
+// payload are checked against it, skipping those deeper than 'max_depth'
+// (0 for no limit); a corpus without payloads is run to 'max_depth' (at
+// least 1) and only the totals are reported. Prints failures and a summary.
+bool run_corpus_suite(const CorpusReader &corpus, std::ostream &out, int threads, int max_depth);
+
+} // namespace chess
+
+#endif // CHESS_SUITE_H
@@ -0,0 +1,60 @@
+ #ifndef CHESS_THREAD_POOL_H
+ #define CHESS_THREAD_POOL_H
+
+ #include <cstddef>
+ #include <mutex>
+ #include <thread>
+ #include <vector>
+
+namespace chess {
+
+// Range of task indices owned by one worker. The owner takes tasks from
+// the front and idle workers steal from the back.
+struct WorkQueue {
+    std::mutex lock;
+    size_t begin = 0;
+    size_t end = 0;
+
+    bool pop_front(size_t &task) {
+        std::lock_guard<std::mutex> guard(lock);
+        if (begin == end) return false;
+        task = begin++;
+        return true;
+    }
+
+    bool steal_back(size_t &task) {
+        std::lock_guard<std::mutex> guard(lock);
+        if (begin == end) return false;
+        task = --end;
+        return true;
+    }
+};
+
+// Run fn(task, worker) for every task in [0, num_tasks) on 'threads' workers.
+// Tasks start split into equal contiguous slices; a worker whose slice runs
+// dry steals from the others until every slice is empty.
+template <typename Fn>
+void parallel_for(size_t num_tasks, int threads, Fn fn) {
+    if (threads < 1) threads = 1;
+    std::vector<WorkQueue> queues(threads);
+    for (int w = 0; w < threads; ++w) {
+        queues[w].begin = num_tasks * w / threads;
+        queues[w].end = num_tasks * (w + 1) / threads;
+    }
+    auto worker = [&](int id) {
+        size_t task;
+        while (queues[id].pop_front(task)) fn(task, id);
+        for (int k = 1; k < threads; ++k) {
+            WorkQueue &victim = queues[(id + k) % threads];
+            while (victim.steal_back(task)) fn(task, id);
+        }
+    };
+    std::vector<std::thread> pool;
+    for (int w = 1; w < threads; ++w) pool.emplace_back(worker, w);
+    worker(0);
+    for (std::thread &t : pool) t.join();
+}
+
+} // namespace chess
+
+#endif // CHESS_THREAD_POOL_H
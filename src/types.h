@@ -7,24 +7,73 @@ namespace chess {
 
 using Bitboard = uint64_t;
 
-enum Piece {
+enum Piece : uint8_t {
     WP, WN, WB, WR, WQ, WK,
     BP, BN, BB, BR, BQ, BK,
     NO_PIECE
 };
 
-enum Color {
+enum Color : uint8_t {
     WHITE = 0,
     BLACK = 1
 };
 
+// Piece kind without color; Piece == color * 6 + PieceType
+enum PieceType {
+    PAWN, KNIGHT, BISHOP, ROOK, QUEEN, KING
+};
+
+constexpr Piece make_piece(Color c, PieceType pt) {
+    return Piece(c * 6 + pt);
+}
+
+// Move flags stored in the top four bits of a Move. Bit 2 marks captures,
+// bit 3 promotions; for promotions the low two bits select the piece.
+enum MoveFlag {
+    QUIET = 0,
+    DOUBLE_PUSH = 1,
+    CASTLING = 2,
+    CAPTURE = 4,
+    EN_PASSANT = 5,
+    PROMOTION = 8,
+    PROMO_KNIGHT = 8, PROMO_BISHOP = 9, PROMO_ROOK = 10, PROMO_QUEEN = 11,
+    PROMO_CAPTURE = 12
+};
+
+// Packed 16-bit move: from (bits 0-5), to (bits 6-11), flags (bits 12-15)
 struct Move {
-    int from;
-    int to;
-    Piece promotion;
-    bool capture;
-    bool en_passant;
-    bool castling;
+    uint16_t data;
+
+    Move() = default;
+    constexpr Move(int from, int to, int flags = QUIET)
+        : data(uint16_t(from | (to << 6) | (flags << 12))) {}
+
+    constexpr int from() const { return data & 63; }
+    constexpr int to() const { return (data >> 6) & 63; }
+    constexpr int flags() const { return data >> 12; }
+    constexpr bool is_capture() const { return data & (CAPTURE << 12); }
+    constexpr bool is_en_passant() const { return flags() == EN_PASSANT; }
+    constexpr bool is_castling() const { return flags() == CASTLING; }
+    constexpr bool is_double_push() const { return flags() == DOUBLE_PUSH; }
+    constexpr bool is_promotion() const { return data & (PROMOTION << 12); }
+    // Promoted piece type; only meaningful when is_promotion()
+    constexpr PieceType promotion_type() const { return PieceType(KNIGHT + (flags() & 3)); }
+
+    constexpr bool operator==(Move o) const { return data == o.data; }
+    constexpr bool operator!=(Move o) const { return data != o.data; }
+};
+
+// Fixed-capacity move list; 256 exceeds the maximum number of legal moves
+struct MoveList {
+    Move moves[256];
+    int count = 0;
+
+    void push_back(Move m) { moves[count++] = m; }
+    void clear() { count = 0; }
+    int size() const { return count; }
+    Move operator[](int i) const { return moves[i]; }
+    const Move *begin() const { return moves; }
+    const Move *end() const { return moves + count; }
 };
 
 } // namespace chess
@@ -0,0 +1,288 @@
+ #include "uci.h"
+ #include "fen.h"
+ #include "game.h"
+ #include "movegen.h"
+ #include "perft.h"
+ #include "search.h"
+ #include <algorithm>
+ #include <atomic>
+ #include <charconv>
+ #include <chrono>
+ #include <istream>
+ #include <mutex>
+ #include <ostream>
+ #include <sstream>
+ #include <string>
+ #include <thread>
+
+namespace chess {
+
+namespace {
+
+constexpr size_t default_hash_mb = 16;
+constexpr int64_t max_hash_mb = 65536;
+constexpr int64_t max_threads = 256;
+// Bound on go's clock values, far beyond any real time control
+constexpr int64_t max_time_ms = int64_t(1) << 40;
+constexpr int perft_split_depth = 2;
+
+class UciEngine {
+public:
+    explicit UciEngine(std::ostream &out) : out_(out), search_(default_hash_mb),
+        perft_table_(default_hash_mb) {}
+    ~UciEngine() { stop(); }
+
+    // Returns false once the session should end
+    bool handle(const std::string &line);
+    // End of input: let bounded work finish, stop unbounded work
+    void finish();
+
+private:
+    void position(std::istringstream &args);
+    void go(std::istringstream &args);
+    void setoption(std::istringstream &args);
+    void stop();
+    void wait();
+    void send(const std::string &text);
+
+    std::ostream &out_;
+    std::mutex out_lock_;
+    Game game_;  // the position with the moves that reached it
+    Search search_;
+    PerftTable perft_table_;
+    int threads_ = 1;
+    std::thread worker_;
+    // Ends the running perft or search; cleared before each go starts one
+    std::atomic<bool> stop_{false};
+    bool infinite_ = false;
+};
+
+void UciEngine::send(const std::string &text) {
+    std::lock_guard<std::mutex> guard(out_lock_);
+    out_ << text << std::endl;
+}
+
+// An infinite search would never end on its own, so it is stopped first
+void UciEngine::wait() {
+    if (infinite_) stop_.store(true, std::memory_order_relaxed);
+    if (worker_.joinable()) worker_.join();
+    infinite_ = false;
+}
+
+void UciEngine::stop() {
+    stop_.store(true, std::memory_order_relaxed);
+    wait();
+}
+
+void UciEngine::finish() {
+    wait();
+}
+
+bool UciEngine::handle(const std::string &line) {
+    std::istringstream args(line);
+    std::string cmd;
+    if (!(args >> cmd)) return true;
+    if (cmd == "uci") {
+        send("id name chessperft\n"
+             "option name Hash type spin default " + std::to_string(default_hash_mb) +
+             " min 1 max " + std::to_string(max_hash_mb) + "\n"
+             "option name Threads type spin default 1 min 1 max " + std::to_string(max_threads) +
+             "\n"
+             "uciok");
+    } else if (cmd == "isready") {
+        send("readyok");
+    } else if (cmd == "ucinewgame") {
+        wait();
+        search_.clear();
+    } else if (cmd == "setoption") {
+        setoption(args);
+    } else if (cmd == "position") {
+        position(args);
+    } else if (cmd == "go") {
+        go(args);
+    } else if (cmd == "stop") {
+        stop();
+    } else if (cmd == "quit") {
+        stop();
+        return false;
+    } else if (cmd == "d") {
+        const Position &pos = game_.position();
+        char fen[FEN_BUFFER_SIZE];
+        write_fen(pos, fen, sizeof(fen));
+        send(position_to_string(pos) + "Fen: " + fen + "\nStatus: " + game_end_string(game_.end()));
+    } else {
+        send("info string Unknown command: " + line);
+    }
+    return true;
+}
+
+// Parse a spin option's value, clamped to [lo, hi]. Returns false unless
+// the whole text is an integer; 'clamped' is set when it was out of range.
+static bool parse_spin(const std::string &text, int64_t lo, int64_t hi, int64_t &value,
+    bool &clamped) {
+    const char *first = text.data(), *last = first + text.size();
+    auto [end, ec] = std::from_chars(first, last, value);
+    if (end != last || ec == std::errc::invalid_argument) return false;
+    // Too many digits for int64_t: clamp by sign
+    if (ec == std::errc::result_out_of_range) value = text[0] == '-' ? lo - 1 : hi + 1;
+    clamped = value < lo || value > hi;
+    value = std::clamp(value, lo, hi);
+    return true;
+}
+
+void UciEngine::setoption(std::istringstream &args) {
+    std::string token, name, value;
+    args >> token >> name >> token >> value;
+    if (token != "value" || value.empty()) {
+        send("info string Expected: setoption name <name> value <value>");
+        return;
+    }
+    if (name != "Hash" && name != "Threads") {
+        send("info string Unknown option: " + name);
+        return;
+    }
+    int64_t n = 0;
+    bool clamped = false;
+    int64_t hi = name == "Hash" ? max_hash_mb : max_threads;
+    if (!parse_spin(value, 1, hi, n, clamped)) {
+        send("info string Invalid value for " + name + ": " + value);
+        return;
+    }
+    if (clamped) send("info string " + name + " must be 1 to " + std::to_string(hi) +
+                      ", using " + std::to_string(n));
+    wait();
+    if (name == "Hash") {
+        search_.resize(size_t(n));
+        perft_table_.resize(size_t(n));
+    } else {
+        threads_ = int(n);
+    }
+}
+
+void UciEngine::position(std::istringstream &args) {
+    wait();
+    std::string token;
+    args >> token;
+    Position pos;
+    if (token == "startpos") {
+        init_position(pos);
+        args >> token;
+    } else if (token == "fen") {
+        std::string fen;
+        while (args >> token && token != "moves") fen += fen.empty() ? token : " " + token;
+        FenError err = parse_fen(fen, pos);
+        if (err != FenError::None) {
+            send("info string Invalid FEN (" + std::string(fen_error_string(err)) + "): " + fen);
+            return;
+        }
+    } else {
+        send("info string Expected: position startpos|fen <fen> [moves ...]");
+        return;
+    }
+    // A bad move keeps the position reached before it
+    game_.reset(pos);
+    if (token == "moves") {
+        while (args >> token) {
+            Move m = move_from_uci(game_.position(), token);
+            if (m == Move(0, 0)) {
+                send("info string Illegal move: " + token);
+                break;
+            }
+            game_.play(m);
+        }
+    }
+}
+
+void UciEngine::go(std::istringstream &args) {
+    wait();
+    SearchLimits limits;
+    int64_t perft_depth = 0, depth = 0, nodes = 0, moves_to_go = 0;
+    int64_t time_left[2] = {0, 0}, increment[2] = {0, 0};
+    bool has_clock[2] = {false, false};
+    std::string token;
+    // Values are clamped like spin options; anything else cancels the go
+    auto number = [&](int64_t lo, int64_t hi, int64_t &value) {
+        std::string text;
+        bool clamped = false;
+        if (!(args >> text) || !parse_spin(text, lo, hi, value, clamped)) {
+            send("info string Invalid value for " + token + ": " + text);
+            return false;
+        }
+        if (clamped) send("info string " + token + " must be " + std::to_string(lo) + " to " +
+                          std::to_string(hi) + ", using " + std::to_string(value));
+        return true;
+    };
+    while (args >> token) {
+        bool ok = true;
+        if (token == "perft") ok = number(1, MAX_PLY, perft_depth);
+        else if (token == "depth") ok = number(1, MAX_PLY, depth);
+        else if (token == "movetime") ok = number(1, max_time_ms, limits.movetime_ms);
+        else if (token == "nodes") ok = number(1, int64_t(1) << 62, nodes);
+        else if (token == "wtime")
+            ok = has_clock[WHITE] = number(-max_time_ms, max_time_ms, time_left[WHITE]);
+        else if (token == "btime")
+            ok = has_clock[BLACK] = number(-max_time_ms, max_time_ms, time_left[BLACK]);
+        else if (token == "winc") ok = number(0, max_time_ms, increment[WHITE]);
+        else if (token == "binc") ok = number(0, max_time_ms, increment[BLACK]);
+        else if (token == "movestogo") ok = number(1, 1000, moves_to_go);
+        if (!ok) return;
+    }
+    limits.depth = int(depth);
+    limits.nodes = uint64_t(nodes);
+
+    stop_.store(false, std::memory_order_relaxed);
+    if (perft_depth > 0) {
+        worker_ = std::thread([this, pos = game_.position(), perft_depth] {
+            auto start = std::chrono::steady_clock::now();
+            uint64_t nodes = perft_parallel(pos, int(perft_depth), threads_, perft_split_depth,
+                                            &perft_table_, &stop_);
+            double secs = std::chrono::duration<double>(
+                std::chrono::steady_clock::now() - start).count();
+            if (stop_.load(std::memory_order_relaxed)) {
+                send("info string Perft(" + std::to_string(perft_depth) + ") stopped");
+                return;
+            }
+            std::ostringstream line;
+            line << "Perft(" << perft_depth << ") : " << nodes << " nodes in " << secs
+                 << " seconds";
+            send(line.str());
+        });
+        return;
+    }
+
+    // Spend a fixed share of the clock on this move; a clock already at or
+    // below zero still gets a minimal search rather than an unbounded one
+    Color us = game_.position().side_to_move;
+    if (!limits.movetime_ms && has_clock[us]) {
+        int64_t share = time_left[us] / (moves_to_go > 0 ? moves_to_go : 30) + increment[us] / 2;
+        limits.movetime_ms = std::max<int64_t>(1, std::min(share, time_left[us] / 2));
+    }
+    infinite_ = !limits.depth && !limits.movetime_ms && !limits.nodes;
+    limits.stop = &stop_;
+    worker_ = std::thread([this, pos = game_.position(), keys = game_.recent_keys(), limits] {
+        SearchResult result = search_.run(pos, limits, [this](const SearchResult &r) {
+            std::ostringstream line;
+            line << "info depth " << r.depth << " seldepth " << r.seldepth << " score "
+                 << score_to_string(r.score) << " nodes " << r.nodes << " nps "
+                 << uint64_t(r.seconds > 0 ? r.nodes / r.seconds : 0) << " time "
+                 << int64_t(r.seconds * 1000) << " pv";
+            for (Move m : r.pv) line << " " << move_to_uci(m);
+            send(line.str());
+        }, keys);
+        send("bestmove " + move_to_uci(result.best));
+    });
+}
+
+} // namespace
+
+void uci_loop(std::istream &in, std::ostream &out) {
+    UciEngine engine(out);
+    std::string line;
+    while (std::getline(in, line)) {
+        if (!line.empty() && line.back() == '\r') line.pop_back();
+        if (!engine.handle(line)) return;
+    }
+    engine.finish();
+}
+
+} // namespace chess
@@ -0,0 +1,21 @@
+ #ifndef CHESS_UCI_H
+ #define CHESS_UCI_H
+
+ #include <iosfwd>
+
+namespace chess {
+
+// Long-lived UCI front end. Reads commands line by line from 'in' and
+// answers on 'out':
+//   uci, isready, ucinewgame, setoption name Hash|Threads value N
+//   position startpos|fen <fen> [moves <uci>...]
+//   go perft N | go [depth N] [movetime MS] [nodes N] [wtime/btime ...] [infinite]
+//   stop, quit, d
+// 'go' runs on a background thread so 'isready' and 'stop' are answered
+// while it works. The search and perft hash tables persist between
+// commands. At end of input a bounded 'go' is allowed to finish.
+void uci_loop(std::istream &in, std::ostream &out);
+
+} // namespace chess
+
+#endif // CHESS_UCI_H